@@ -1,146 +1,4223 @@
-#ifndef CPPUNIT_TO_GTEST_HEADER_
+// The header is in layers so the CppUnit style shim headers only parse what they need.
+//  The shims define CppUnit2Gtest_IncludeLayer_ to stop after a layer:
+//   1 portability (cppunit/portability/Stream.h, cppunit/config/SourcePrefix.h)
+//   2 assertions (cppunit/TestAssert.h)
+//  without it everything is included
+
+#ifndef CPPUNIT_TO_GTEST_PORTABILITY_HEADER_
+#define CPPUNIT_TO_GTEST_PORTABILITY_HEADER_
+
+#include <iostream>
+
+#define CppUnit2Gtest
+#define CppUnit2Gtest_VERSION   "0.0.0"
+#define CPPUNIT_VERSION         "CppUnit2Gtest"
+#define CPPUNIT_NS              ::CppUnit
+#define CPPUNIT_NS_BEGIN        namespace CppUnit {
+#define CPPUNIT_NS_END          }
+
+namespace CppUnit {
+// CppUnit does some odd things in the name of portability
+//  We end up undoing them by default (ironically to maintain portability)
+/// Define to avoid the CppUnit::OStream being defined (allows for user defined custom streams)
+#ifndef Cppunit2Gtest_NoDeclOStream
+#   if defined(Cppunit2Gtest_StreamType)
+        using OStream = Cppunit2Gtest_StreamType;
+#   else
+        using OStream = std::ostream;
+#   endif
+#   if defined(Cppunit2Gtest_CustomCout)
+        inline auto stdCOut() { return Cppunit2Gtest_CustomCout; }
+#   else
+        inline auto& stdCOut() { return std::cout; }
+#   endif
+#endif
+}
+
+#define CppUnit2Gtest_BadCast_ static_assert(false, "This did a C style cast and is unlikely to be what you wanted")
+#define CPPUNIT_STATIC_CAST(a, b)   CppUnit2Gtest_BadCast_
+#define CPPUNIT_CONST_CAST(a,b)     CppUnit2Gtest_BadCast_
+
+#endif // CPPUNIT_TO_GTEST_PORTABILITY_HEADER_
+
+#if (!defined(CppUnit2Gtest_IncludeLayer_) || CppUnit2Gtest_IncludeLayer_ >= 2) && !defined(CPPUNIT_TO_GTEST_ASSERT_HEADER_)
+#define CPPUNIT_TO_GTEST_ASSERT_HEADER_
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+namespace CppUnit { namespace to { namespace gtest {
+    // Stream operators make things forward compatable with gtest
+    struct ExitingAssertion : std::stringstream { };
+}}}
+
+#if defined(CppUnit2Gtest_AllowAssertsInConstructors)
+
+/// Note: gtest args must be surrounded by brackets: 
+//   CppUnit2Gtest_assertion_wrapper_(TRUE, (true))
+//   CppUnit2Gtest_assertion_wrapper_(TRUE, (true) << "expected true")
+#   define CppUnit2Gtest_assertion_wrapper_(gtest_assertion, args) \
+    EXPECT_ ## gtest_assertion args ; if (::testing::Test::HasFailure()) throw ::CppUnit::to::gtest::ExitingAssertion{} 
+
+#   define CppUnit2Gtest_fail_wrapper_() ADD_FAILURE()
+
+#else // CppUnit2Gtest_AllowAssertsInConstructors
+#   define CppUnit2Gtest_assertion_wrapper_(gtest_assertion, args) \
+    ASSERT_ ## gtest_assertion args 
+
+#   define CppUnit2Gtest_fail_wrapper_() FAIL()
+
+#endif
+
+// Asserting
+#define CPPUNIT_ASSERT(condition)                                    CppUnit2Gtest_assertion_wrapper_(TRUE, (condition))
+#define CPPUNIT_ASSERT_MESSAGE(message, condition)                   CppUnit2Gtest_assertion_wrapper_(TRUE, (condition) << message)
+#define CPPUNIT_ASSERT_EQUAL(a, b)                                   CppUnit2Gtest_assertion_wrapper_(EQ, (a, b))
+#define CPPUNIT_ASSERT_EQUAL_MESSAGE(msg, a, b)                      CppUnit2Gtest_assertion_wrapper_(EQ, (a, b) << msg)
+#define CPPUNIT_ASSERT_NO_THROW(expression)                          CppUnit2Gtest_assertion_wrapper_(NO_THROW,(expression))
+#define CPPUNIT_ASSERT_NO_THROW_MESSAGE(msg, expression)             CppUnit2Gtest_assertion_wrapper_(NO_THROW,(expression) << message)
+#define CPPUNIT_ASSERT_THROW(expression, expected)                   CppUnit2Gtest_assertion_wrapper_(THROW, (expression, expected))
+#define CPPUNIT_ASSERT_THROW_MESSAGE(message, expression, expected)  CppUnit2Gtest_assertion_wrapper_(THROW,(expression, expected) << message)
+#define CPPUNIT_ASSERT_DOUBLES_EQUAL(a,b, t)                         CppUnit2Gtest_assertion_wrapper_(NEAR, (a, b, t))
+#define CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(msg, a, b, t)           CppUnit2Gtest_assertion_wrapper_(NEAR, (a, b, t) << msg)
+#define CPPUNIT_FAIL(message)                                        CppUnit2Gtest_fail_wrapper_() << message
+#define CPPUNIT_ASSERT_ASSERTION_PASS(e)                             CppUnit2Gtest_assertion_wrapper_(NO_THROW, (e))
+#define CPPUNIT_ASSERT_ASSERTION_PASS_MESSAGE(msg, e)                CppUnit2Gtest_assertion_wrapper_(NO_THROW, (e) << msg)
+#define CPPUNIT_ASSERT_LESS(expected, actual)                        CppUnit2Gtest_assertion_wrapper_(LT, (actual, expected))
+#define CPPUNIT_ASSERT_LESSEQUAL(expected, actual)                   CppUnit2Gtest_assertion_wrapper_(LE, (actual, expected))
+#define CPPUNIT_ASSERT_GREATER(expected, actual)                     CppUnit2Gtest_assertion_wrapper_(GT, (actual, expected))
+#define CPPUNIT_ASSERT_GREATEREQUAL(expected, actual)                CppUnit2Gtest_assertion_wrapper_(GE, (actual, expected))
+
+// These aren't in CppUnit but we can be nicer to the user
+#define CPPUNIT_ASSERT_LESS_MESSAGE(msg, expected, actual)           CppUnit2Gtest_assertion_wrapper_(LT, (actual, expected) << msg)
+#define CPPUNIT_ASSERT_GREATER_MESSAGE(msg, expected, actual)        CppUnit2Gtest_assertion_wrapper_(GT, (actual, expected) << msg)
+#define CPPUNIT_ASSERT_LESSEQUAL_MESSAGE(msg, expected, actual)      CppUnit2Gtest_assertion_wrapper_(LE, (actual, expected) << msg)
+#define CPPUNIT_ASSERT_GREATEREQUAL_MESSAGE(msg, expected, actual)   CppUnit2Gtest_assertion_wrapper_(GE, (actual, expected) << msg)
+
+#define CppUnit2Gtest_FailCompilation_NotSupported_ static_assert(false, \
+    "This CppUnit macro is not supported. Please rewrite this test in GTest or with implmented macros")
+
+// Some assertions are intentionally not added, they should really be re-written
+#define CPPUNIT_ASSERT_ASSERTION_FAIL(t)            CppUnit2Gtest_FailCompilation_NotSupported_
+#define CPPUNIT_EXTRACT_EXCEPTION_TYPE_(t)          CppUnit2Gtest_FailCompilation_NotSupported_
+#define CPPUNIT_ASSERT_ASSERTION_FAIL_MESSAGE(t)    CppUnit2Gtest_FailCompilation_NotSupported_
+
+#endif // CPPUNIT_TO_GTEST_ASSERT_HEADER_
+
+#if !defined(CppUnit2Gtest_IncludeLayer_) && !defined(CPPUNIT_TO_GTEST_HEADER_)
 #define CPPUNIT_TO_GTEST_HEADER_
 
-#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Platform headers (and platform checks) for the optional features
+
+#if defined(CppUnit2Gtest_EnableTimeouts)
+#   if defined(__linux__) && defined(__GLIBC__)
+#       include <dirent.h>
+#       include <execinfo.h>
+#       include <sys/syscall.h>
+#       include <unistd.h>
+#   endif
+#endif
+
+#if defined(CppUnit2Gtest_EnableResultCache)
+#   if !defined(__unix__)
+#       error "CppUnit2Gtest_EnableResultCache is only supported on unix like platforms"
+#   endif
+#   include <dirent.h>
+#   include <sys/stat.h>
+#   include <utime.h>
+#   if defined(__GLIBC__)
+#       include <link.h>
+#   endif
+#endif
+
+#if defined(CppUnit2Gtest_EnableDaemon)
+#   if !defined(__unix__) && !defined(__APPLE__)
+#       error "CppUnit2Gtest_EnableDaemon is only supported on unix like platforms"
+#   endif
+#   include <sys/socket.h>
+#   include <sys/un.h>
+#   include <sys/wait.h>
+#   include <unistd.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnableScheduling)
+#   if !defined(__unix__) && !defined(__APPLE__)
+#       error "CppUnit2Gtest_EnableScheduling is only supported on unix like platforms"
+#   endif
+#   include <sys/wait.h>
+#   include <unistd.h>
+#   if defined(__linux__)
+#       include <sched.h>
+#   endif
+#endif
+
+#if defined(CppUnit2Gtest_EnableForkIsolation) || defined(CppUnit2Gtest_EnableRetries)
+#   include <gtest/gtest-spi.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnableForkIsolation)
+#   if !defined(__unix__) && !defined(__APPLE__)
+#       error "CppUnit2Gtest_EnableForkIsolation is only supported on unix like platforms"
+#   endif
+#   include <poll.h>
+#   include <sys/wait.h>
+#   include <unistd.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnableWatch)
+#   if !defined(__linux__)
+#       error "CppUnit2Gtest_EnableWatch is only supported on linux"
+#   endif
+// Watched plugins are loaded like any other
+#   if !defined(CppUnit2Gtest_EnablePlugins)
+#       define CppUnit2Gtest_EnablePlugins
+#   endif
+#   include <poll.h>
+#   include <sys/inotify.h>
+#   include <sys/stat.h>
+#   include <sys/wait.h>
+#   include <unistd.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnablePlugins)
+#   if !defined(__unix__) && !defined(__APPLE__)
+#       error "CppUnit2Gtest_EnablePlugins is only supported on unix like platforms"
+#   endif
+#   include <dirent.h>
+#   include <dlfcn.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnablePerfCounters)
+#   if !defined(__linux__)
+#       error "CppUnit2Gtest_EnablePerfCounters is only supported on linux"
+#   endif
+#   include <linux/perf_event.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnableSamplingProfiler)
+#   if !defined(__linux__) || !defined(__GLIBC__)
+#       error "CppUnit2Gtest_EnableSamplingProfiler is only supported on linux with glibc"
+#   endif
+#   if !defined(__x86_64__) && !defined(__aarch64__)
+#       error "CppUnit2Gtest_EnableSamplingProfiler only walks the stacks of x86_64 and aarch64"
+#   endif
+#   include <cxxabi.h>
+#   include <execinfo.h>
+#   include <pthread.h>
+#   include <sys/syscall.h>
+#   include <time.h>
+#   include <ucontext.h>
+#   include <unistd.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnableMappedParameters) || defined(CppUnit2Gtest_EnableGoldenFiles)
+#   if !defined(__unix__) && !defined(__APPLE__)
+#       error "CppUnit2Gtest_EnableMappedParameters and CppUnit2Gtest_EnableGoldenFiles are only supported on unix like platforms"
+#   endif
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#if defined(CppUnit2Gtest_EnableStreamingOutput) || defined(CppUnit2Gtest_EnablePrioritization) || defined(CppUnit2Gtest_EnableTracing)
+#   if defined(_WIN32)
+#       include <process.h>
+#       define CppUnit2Gtest_getpid_ _getpid
+#   else
+#       include <unistd.h>
+#       define CppUnit2Gtest_getpid_ getpid
+#   endif
+#endif
+
+namespace CppUnit {
+
+    class TestCase : public testing::Test
+    {
+    public:
+        // Take Cppunit style functions
+        virtual void setUp() {}
+        virtual void tearDown() {}
+
+        // Name forward to gtest equivalents
+        void SetUp() override { setUp(); }
+        void TearDown() override { tearDown(); }
+    };
+
+    using TestFixture = TestCase;
+
+namespace to { namespace gtest {
+#define CppUnit2Gtest_CHECK(condition) \
+        if (!(condition)) { \
+            throw std::runtime_error("Internal Check failed when running test harness " #condition ); \
+        }
+
+    /// Key value pairs given by CPPUNIT_TEST_SUITE_PROPERTY, later entries take priority
+    using Properties = std::vector<std::pair<std::string, std::string>>;
+
+    /// Returns the value of the last property with the given key or nullptr if there isn't one
+    inline const std::string* FindProperty(const Properties& properties, const std::string& key) {
+        const std::string* found = nullptr;
+        for (const auto& property : properties) {
+            if (property.first == key) { found = &property.second; }
+        }
+        return found;
+    }
+
+    /// True for the properties that configure how the adaptor runs a test rather than describe it,
+    ///  these aren't recorded in gtest's output
+    inline bool IsControlProperty_(const std::string& key) {
+        static const char* const controlKeys[] = {
+            "timeout_ms", "retries", "isolation", "cpus", "memory_mb", "exclusive", "slow", "parallel_safe"};
+        for (const char* controlKey : controlKeys) {
+            if (key == controlKey) { return true; }
+        }
+        return false;
+    }
+
+    /// The name a property is recorded under, gtest fails a test that records one of its own attributes
+    ///  so those get a "property_" prefix
+    inline std::string RecordedPropertyName_(const std::string& key) {
+        static const char* const reservedNames[] = {
+            "classname", "name", "status", "time", "type_param", "value_param", "file", "line", "result", "timestamp"};
+        for (const char* reservedName : reservedNames) {
+            if (key == reservedName) { return "property_" + key; }
+        }
+        return key;
+    }
+
+    /// Called with the test name and a reason before the adaptor aborts the process (i.e. on a timeout)
+    ///  so that anything buffered can be written out
+    using AbortHandler = void(*)(const std::string& testName, const std::string& reason);
+    inline std::vector<AbortHandler>& AbortHandlers_() {
+        static std::vector<AbortHandler> handlers;
+        return handlers;
+    }
+
+    /// What enabled features add to TestFactoryRegistry and TextTestRunner, so those classes are the same
+    ///  in every translation unit whichever features it enables. A feature enabled in any of them adds its hooks
+    struct MainHooks_ {
+        /// Run by TestFactoryRegistry::makeTest before it lists the tests
+        std::vector<void(*)()> beforeListing;
+        /// Tried in order by TextTestRunner::run after InitGoogleTest, the first that returns true
+        ///  ran the tests instead of RUN_ALL_TESTS and set passed
+        std::vector<bool(*)(bool& passed)> runners;
+
+        static MainHooks_& Instance() {
+            static MainHooks_ hooks;
+            return hooks;
+        }
+    };
+
+    /// Holds data required for each test.
+    template<typename FromClass>
+    struct TestData {
+        using TestMethodType = void(*)(FromClass&);
+        TestMethodType testMethod;
+        unsigned int line = 0;
+        const char* testName;
+        Properties properties{};
+        const char* file = nullptr; // Where the test was added, the registration's file is used if null
+        /// Called instead of testMethod by tests that carry state, i.e. a chunk of CPPUNIT_TEST_PARAMETERIZED cases
+        std::function<void(FromClass&)> boundMethod{};
+        /// Owns testName when it is built at registration
+        std::shared_ptr<const std::string> ownedName{};
+
+        TestData(const TestMethodType testMethod_, const unsigned int line_, const char* testName_, const char* file_ = nullptr)
+            : testMethod(testMethod_)
+            , line(line_)
+            , testName(testName_)
+            , file(file_)
+        {
+            CppUnit2Gtest_CHECK(testMethod != nullptr);
+            CppUnit2Gtest_CHECK(testName != nullptr);
+            CppUnit2Gtest_CHECK(testName_ != nullptr);
+        }
+
+        TestData(const TestData&) = default;
+        TestData(TestData&&) = default;
+        TestData& operator=(const TestData&) = default;
+        TestData& operator=(TestData&&) = default;
+        // Allow casting to another class type that inherits the current one
+        template<typename Derived>
+        explicit TestData(TestData<Derived>& from)
+            : testMethod(TestMethodType(from.testMethod))
+            , line(from.line)
+            , testName(from.testName)
+            , properties(from.properties)
+            , file(from.file)
+            , boundMethod(from.boundMethod)
+            , ownedName(from.ownedName)
+        {
+            CppUnit2Gtest_CHECK(testMethod != nullptr);
+            CppUnit2Gtest_CHECK(testName != nullptr);
+            CppUnit2Gtest_CHECK(from.testMethod != nullptr);
+        }
+    };
+
+    /// Applies the properties given in a suite to each of its tests.
+    ///  Keys of the form "testName.key" only apply to that test and take priority over the suite's
+    template<typename TestDataType>
+    std::vector<TestDataType> ApplyProperties(std::vector<TestDataType> allTestData, const Properties& suiteProperties) {
+        const auto isTestName = [&allTestData](const std::string& name) {
+            for (const auto& testData : allTestData) {
+                if (name == testData.testName) { return true; }
+            }
+            return false;
+        };
+        Properties suiteWide;
+        Properties perTest;
+        for (const auto& property : suiteProperties) {
+            const auto dot = property.first.find('.');
+            const bool forTest = dot != std::string::npos && isTestName(property.first.substr(0, dot));
+            (forTest ? perTest : suiteWide).push_back(property);
+        }
+        for (auto& testData : allTestData) {
+            const std::string prefix = std::string{testData.testName} + ".";
+            testData.properties.insert(testData.properties.end(), suiteWide.begin(), suiteWide.end());
+            for (const auto& property : perTest) {
+                if (property.first.compare(0, prefix.size(), prefix) == 0) {
+                    testData.properties.emplace_back(property.first.substr(prefix.size()), property.second);
+                }
+            }
+        }
+        return allTestData;
+    }
+
+/// At most this many tests are registered for each CPPUNIT_TEST_PARAMETERIZED, more cases are run in chunks
+#ifndef CppUnit2Gtest_ParameterizedTestLimit
+#   define CppUnit2Gtest_ParameterizedTestLimit 100
+#endif
+
+    /// Ranges of a parameter source's positions, each registered as one test
+    using ParameterChunks = std::vector<std::pair<size_t, size_t>>;
+
+    /// Splits [0, size) into at most limit ranges of (nearly) equal size
+    inline ParameterChunks EvenChunks_(const size_t size, const size_t limit) {
+        ParameterChunks chunks;
+        const size_t count = std::min(size, std::max<size_t>(limit, 1));
+        for (size_t chunk = 0; chunk < count; ++chunk) {
+            chunks.emplace_back(size * chunk / count, size * (chunk + 1) / count);
+        }
+        return chunks;
+    }
+
+    /// Sources derived from this are used as they are, anything else is copied into VectorParameters.
+    ///  A source has Chunks(limit), ForEach(begin, end, run(parameter, position)), PositionName() and Error()
+    struct ParameterSourceTag {};
+
+    /// Cases given as a container or a braced list, copied once and shared by the chunks
+    template<typename T>
+    struct VectorParameters : ParameterSourceTag {
+        std::shared_ptr<const std::vector<T>> values;
+
+        explicit VectorParameters(std::vector<T> values_) : values(std::make_shared<const std::vector<T>>(std::move(values_))) {}
+        [[nodiscard]] ParameterChunks Chunks(const size_t limit) const { return EvenChunks_(values->size(), limit); }
+        [[nodiscard]] static const char* PositionName() { return "case"; }
+        [[nodiscard]] static std::string Error() { return {}; }
+        template<typename Case>
+        void ForEach(const size_t begin, const size_t end, const Case& run) const {
+            for (size_t i = begin; i < end; ++i) { run((*values)[i], i); }
+        }
+    };
+
+    template<typename T>
+    VectorParameters<T> ParametersOf_(std::initializer_list<T> values) {
+        return VectorParameters<T>(std::vector<T>(values));
+    }
+
+    template<typename Source, typename std::enable_if<std::is_base_of<ParameterSourceTag, Source>::value, int>::type = 0>
+    Source ParametersOf_(Source source) { return source; }
+
+    template<typename Container, typename std::enable_if<!std::is_base_of<ParameterSourceTag, Container>::value, int>::type = 0>
+    auto ParametersOf_(const Container& container) {
+        using Value = typename std::decay<decltype(*std::begin(container))>::type;
+        return VectorParameters<Value>(std::vector<Value>(std::begin(container), std::end(container)));
+    }
+
+    /// Runs a case so that a failure or exception in it doesn't stop the rest of the chunk
+    template<typename Case>
+    void RunParameterizedCase_(const Case& run) {
+        try {
+            run();
+        } catch (const ExitingAssertion& e) {
+            ADD_FAILURE() << e.str();
+        } catch (const std::exception& e) {
+            ADD_FAILURE() << "Uncaught exception: " << e.what();
+        }
+    }
+
+    /// Adds a test built at registration, named by the string it owns and running bound instead of a method
+    template<typename Fixture>
+    void AddBoundTest_(std::vector<TestData<Fixture>>& allTestData, std::string name,
+        const unsigned int line, const char* file, std::function<void(Fixture&)> bound)
+    {
+        TestData<Fixture> testData(+[](Fixture&) {}, line, "", file);
+        testData.ownedName = std::make_shared<const std::string>(std::move(name));
+        testData.testName = testData.ownedName->c_str();
+        testData.boundMethod = std::move(bound);
+        allTestData.push_back(std::move(testData));
+    }
+
+    /// Adds a test per chunk of the source's cases, named "method/first-last" (or "method/index").
+    ///  Each case runs with the fixture's tearDown and setUp between them, a failure names its position
+    template<typename Fixture, typename Source, typename Method>
+    void AddParameterizedTests_(std::vector<TestData<Fixture>>& allTestData, const char* testName,
+        const unsigned int line, const char* file, const Source& source, Method method)
+    {
+        const auto add = [&](std::string name, std::function<void(Fixture&)> bound) {
+            AddBoundTest_(allTestData, std::move(name), line, file, std::move(bound));
+        };
+        const std::string error = source.Error();
+        if (!error.empty()) {
+            add(testName, [error](Fixture&) { FAIL() << "No parameters: " << error; });
+            return;
+        }
+        for (const auto& chunk : source.Chunks(CppUnit2Gtest_ParameterizedTestLimit)) {
+            const size_t begin = chunk.first;
+            const size_t end = chunk.second;
+            const std::string range = end - begin == 1 ? std::to_string(begin) : std::to_string(begin) + "-" + std::to_string(end - 1);
+            add(std::string(testName) + "/" + range, [source, method, begin, end, file, line](Fixture& fixture) {
+                bool first = true;
+                source.ForEach(begin, end, [&](const auto& parameter, const size_t position) {
+                    if (!first) {
+                        fixture.tearDown();
+                        fixture.setUp();
+                    }
+                    first = false;
+                    const ::testing::ScopedTrace trace(file, static_cast<int>(line),
+                        ::testing::Message() << source.PositionName() << ' ' << position);
+                    RunParameterizedCase_([&]() { method(fixture, parameter); });
+                });
+            });
+        }
+    }
+
+    /// Tests generated at run time, i.e. one per file of a directory.
+    ///  Names() is called once at registration so should be cheap, Run builds a test's heavy state when it runs
+    template<typename Fixture>
+    struct TestGenerator {
+        virtual ~TestGenerator() = default;
+        [[nodiscard]] virtual std::vector<std::string> Names() const = 0;
+        /// Runs the test at index of Names() on a fresh fixture, after its setUp
+        virtual void Run(Fixture& fixture, size_t index) const = 0;
+    };
+
+    /// Given to the method named by CPPUNIT_TEST_SUITE_ADD_CUSTOM_TESTS to add tests to the suite
+    template<typename Fixture>
+    class CustomTests {
+        std::vector<TestData<Fixture>>& allTestData;
+        const char* file;
+        unsigned int line;
+
+    public:
+        CustomTests(std::vector<TestData<Fixture>>& allTestData_, const char* file_, const unsigned int line_)
+            : allTestData(allTestData_), file(file_), line(line_) {}
+
+        /// Adds a test calling run, which should build anything expensive itself rather than capture it
+        void Add(std::string name, std::function<void(Fixture&)> run) {
+            AddBoundTest_(allTestData, std::move(name), line, file, std::move(run));
+        }
+
+        /// Adds a test for each of the generator's names, they share the generator
+        void Add(std::shared_ptr<const TestGenerator<Fixture>> generator) {
+            CppUnit2Gtest_CHECK(generator != nullptr);
+            const auto names = generator->Names();
+            for (size_t i = 0; i < names.size(); ++i) {
+                Add(names[i], [generator, i](Fixture& fixture) { generator->Run(fixture, i); });
+            }
+        }
+    };
+
+#if defined(CppUnit2Gtest_EnableMappedParameters) || defined(CppUnit2Gtest_EnableGoldenFiles)
+    /// A whole file mapped read only, empty files and errors have no data
+    class MappedFile {
+        const char* data = nullptr;
+        size_t size = 0;
+        std::string error;
+
+    public:
+        explicit MappedFile(const std::string& path) {
+            const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat status {};
+            if (fd < 0 || fstat(fd, &status) != 0) {
+                error = "cannot open " + path + ": " + std::strerror(errno);
+            } else if (status.st_size > 0) {
+                void* mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped == MAP_FAILED) {
+                    error = "cannot map " + path + ": " + std::strerror(errno);
+                } else {
+                    data = static_cast<const char*>(mapped);
+                    size = static_cast<size_t>(status.st_size);
+                    madvise(mapped, size, MADV_SEQUENTIAL);
+                }
+            }
+            if (fd >= 0) { close(fd); }
+        }
+        ~MappedFile() {
+            if (data != nullptr) { munmap(const_cast<char*>(data), size); }
+        }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        [[nodiscard]] const char* Data() const { return data; }
+        [[nodiscard]] size_t Size() const { return size; }
+        /// Why the file couldn't be mapped, empty if it was
+        [[nodiscard]] const std::string& Error() const { return error; }
+    };
+#endif
+
+#if defined(CppUnit2Gtest_EnableMappedParameters)
+    /// Cases read from a file mapped into memory, each handed out as a std::string_view into the mapping.
+    ///  Lines of a text file (chunked by byte ranges, so positions are byte offsets) or fixed size records.
+    ///  The mapping stays live until the tests finish, the file must not change meanwhile (truncating it raises SIGBUS)
+    class MappedParameters : public ParameterSourceTag {
+        std::shared_ptr<const MappedFile> mapping;
+        size_t recordSize = 0;
+
+        MappedParameters(const std::string& path, const size_t recordSize_)
+            : mapping(std::make_shared<const MappedFile>(path)), recordSize(recordSize_) {}
+
+        /// The first line starting at or after position
+        [[nodiscard]] size_t LineStart(const size_t position) const {
+            if (position == 0 || position >= mapping->Size()) { return std::min(position, mapping->Size()); }
+            const void* newline = std::memchr(mapping->Data() + position - 1, '\n', mapping->Size() - position + 1);
+            return newline == nullptr ? mapping->Size() : static_cast<size_t>(static_cast<const char*>(newline) - mapping->Data()) + 1;
+        }
+
+    public:
+        /// One case per line, without its line ending
+        static MappedParameters Lines(const std::string& path) { return MappedParameters(path, 0); }
+        /// One case per recordSize bytes, a partial record at the end is left out
+        static MappedParameters Records(const std::string& path, const size_t recordSize) {
+            return MappedParameters(path, std::max<size_t>(recordSize, 1));
+        }
+
+        [[nodiscard]] std::string Error() const { return mapping->Error(); }
+        [[nodiscard]] const char* PositionName() const { return recordSize == 0 ? "line at byte" : "record"; }
+
+        [[nodiscard]] ParameterChunks Chunks(const size_t limit) const {
+            if (recordSize != 0) { return EvenChunks_(mapping->Size() / recordSize, limit); }
+            // Split the bytes evenly then move each split to the start of a line, so only the line ends are searched
+            ParameterChunks chunks;
+            size_t begin = 0;
+            for (const auto& bytes : EvenChunks_(mapping->Size(), limit)) {
+                const size_t end = LineStart(bytes.second);
+                if (end > begin) { chunks.emplace_back(begin, end); }
+                begin = std::max(begin, end);
+            }
+            return chunks;
+        }
+
+        template<typename Case>
+        void ForEach(const size_t begin, const size_t end, const Case& run) const {
+            if (recordSize != 0) {
+                for (size_t i = begin; i < end; ++i) { run(std::string_view(mapping->Data() + i * recordSize, recordSize), i); }
+                return;
+            }
+            for (size_t start = LineStart(begin); start < end; ) {
+                const void* newline = std::memchr(mapping->Data() + start, '\n', mapping->Size() - start);
+                const size_t stop = newline == nullptr ? mapping->Size() : static_cast<size_t>(static_cast<const char*>(newline) - mapping->Data());
+                const size_t length = stop > start && mapping->Data()[stop - 1] == '\r' ? stop - start - 1 : stop - start;
+                run(std::string_view(mapping->Data() + start, length), start);
+                start = stop + 1;
+            }
+        }
+    };
+#endif // CppUnit2Gtest_EnableMappedParameters
+
+#if defined(CppUnit2Gtest_EnablePerformanceAssertions) || defined(CppUnit2Gtest_EnableRegistrationStats)
+    /// Allocations made by this thread, counted by the operator new defined with CppUnit2Gtest_CountAllocations
+    inline unsigned long long& AllocationCount_() {
+        thread_local unsigned long long count = 0;
+        return count;
+    }
+
+    inline bool& AllocationCounterInstalled_() {
+        static bool installed = false;
+        return installed;
+    }
+#endif
+#if defined(CppUnit2Gtest_EnableTimeouts)
+    inline void ArmWatchdog_(const Properties& properties);
+    inline void DisarmWatchdog_();
+#endif
+#if defined(CppUnit2Gtest_EnableStreamingOutput)
+    inline void InstallStreamingOutput_();
+#endif
+#if defined(CppUnit2Gtest_EnableImpactSelection)
+    /// True if the test should run given the changed files, tests that can't be ruled out always run
+    inline bool IsImpacted_(const std::string& suite, const std::string& test, const std::string& file);
+#endif
+#if defined(CppUnit2Gtest_EnableResultCache)
+    /// True if the test passed in a previous run of an identical binary (and environment)
+    inline bool HasCachedPass_(const std::string& suite, const std::string& test);
+
+    /// Stands in for a test that passed last time, so its fixture isn't constructed
+    struct CachedPassTest : ::testing::Test {
+        void TestBody() override { RecordProperty("cached", "true"); }
+    };
+
+    /// Stands in for a test that passed last time in a suite that still runs other tests.
+    ///  gtest wants every test of a suite to have its fixture so that is constructed, setUp, the test and tearDown aren't run
+    template<typename RegisteredTest>
+    struct CachedPassFixture : RegisteredTest {
+        using RegisteredTest::RegisteredTest;
+        void SetUp() override {}
+        void TearDown() override {}
+        void TestBody() override { ::testing::Test::RecordProperty("cached", "true"); }
+    };
+#endif
+#if defined(CppUnit2Gtest_EnablePrioritization)
+    /// Holds a suite's registration back (returns true) so suites can be registered in priority order
+    inline bool DeferRegistration_(const std::string& suite, std::vector<std::string> testNames, std::function<void()> registration);
+    /// True if test a of the suite should run before test b (recently failed, then fast)
+    inline bool RunsBefore_(const std::string& suite, const char* a, const char* b);
+    /// True once a test failed in another worker sharing CPPUNIT2GTEST_STOP_FILE
+    inline bool StopRequested_();
+#endif
+#if defined(CppUnit2Gtest_EnableScheduling)
+    /// Keeps the properties of registered tests for the scheduler
+    inline void RecordSchedulingProperties_(const std::string& suite, const std::string& test, const Properties& properties);
+#endif
+#if defined(CppUnit2Gtest_EnablePerfCounters)
+    /// Adds the listener that totals the counts per suite, in the process that runs the tests
+    inline void InstallPerfCounters_();
+    inline void StartPerfCounters_();
+    /// Stops the counters and records the counts as properties of the running test
+    inline void StopPerfCounters_();
+
+    /// Counts hardware events while a test method runs, even if it throws
+    struct PerfCountersScope_ {
+        PerfCountersScope_() { StartPerfCounters_(); }
+        ~PerfCountersScope_() { StopPerfCounters_(); }
+        PerfCountersScope_(const PerfCountersScope_&) = delete;
+        PerfCountersScope_& operator=(const PerfCountersScope_&) = delete;
+    };
+#endif
+#if defined(CppUnit2Gtest_EnableSamplingProfiler)
+    /// Samples the stacks while the method of a test chosen by CPPUNIT2GTEST_SAMPLE_TESTS runs
+    inline bool StartSampling_();
+    /// Stops sampling and writes the folded stacks of the test
+    inline void StopSampling_();
+
+    struct SamplingScope_ {
+        bool sampling = StartSampling_();
+        ~SamplingScope_() { if (sampling) { StopSampling_(); } }
+        SamplingScope_() = default;
+        SamplingScope_(const SamplingScope_&) = delete;
+        SamplingScope_& operator=(const SamplingScope_&) = delete;
+    };
+#endif
+#if defined(CppUnit2Gtest_EnableTracing)
+    /// True when CPPUNIT2GTEST_TRACE_FILE is set
+    inline bool Tracing_();
+    /// Microseconds since tracing started
+    inline double TraceNow_();
+    /// Buffers a complete event for the calling thread
+    inline void TraceComplete_(const char* category, const std::string& name, double start, double end);
+    /// Writes the calling thread's events now, i.e. before a forked child exits
+    inline void FlushTrace_();
+
+    /// Records a trace event lasting until the end of the scope
+    struct TraceScope_ {
+        const char* category;
+        std::string name;
+        double start = 0;
+        TraceScope_(const char* category_, std::string name_) : category(category_), name(std::move(name_)) {
+            if (Tracing_()) { start = TraceNow_(); }
+        }
+        ~TraceScope_() {
+            if (Tracing_()) { TraceComplete_(category, name, start, TraceNow_()); }
+        }
+        TraceScope_(const TraceScope_&) = delete;
+        TraceScope_& operator=(const TraceScope_&) = delete;
+    };
+
+    inline std::string CurrentSuiteName_() {
+        const ::testing::TestSuite* suite = ::testing::UnitTest::GetInstance()->current_test_suite();
+        return suite != nullptr ? suite->name() : "";
+    }
+#endif
+#if defined(CppUnit2Gtest_EnableRegistrationStats)
+    /// What registering a suite cost during static initialization
+    struct RegistrationStats {
+        std::string suite;
+        std::string file;
+        size_t tests = 0;
+        double milliseconds = 0;
+        /// Only counted with CppUnit2Gtest_CountAllocations
+        unsigned long long allocations = 0;
+    };
+
+    inline void RecordRegistration_(RegistrationStats stats);
+
+    /// Measures a suite's registration until the end of the scope
+    struct RegistrationStatsScope_ {
+        RegistrationStats stats;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        unsigned long long allocations = AllocationCount_();
+
+        RegistrationStatsScope_(const char* suite, const char* file) {
+            stats.suite = suite;
+            stats.file = file;
+        }
+        ~RegistrationStatsScope_() {
+            stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats.allocations = AllocationCount_() - allocations;
+            RecordRegistration_(std::move(stats));
+        }
+        RegistrationStatsScope_(const RegistrationStatsScope_&) = delete;
+        RegistrationStatsScope_& operator=(const RegistrationStatsScope_&) = delete;
+    };
+#endif
+#if defined(CppUnit2Gtest_EnableRetries)
+    /// Extra attempts a failing test gets from the "retries" property or CPPUNIT2GTEST_RETRIES, 0 for none
+    inline int Retries_(const Properties& properties);
+    /// Runs a stage of an attempt with its results going to results rather than the test,
+    ///  exceptions fail the attempt like gtest reports them
+    inline void RunAttemptStage_(::testing::TestPartResultArray& results, const std::function<void()>& stage, const char* where);
+    /// True when an attempt failed, fatally or not
+    inline bool AttemptFailed_(const ::testing::TestPartResultArray& results);
+    /// True when the attempt can't go on to its next stage (a fatal failure or a skip)
+    inline bool AttemptStopped_(const ::testing::TestPartResultArray& results);
+    /// Reports an attempt's results in the running test
+    inline void ReportAttempt_(const ::testing::TestPartResultArray& results);
+    /// The first failure of an attempt, for the properties of a test that was retried
+    inline std::string FirstFailure_(const ::testing::TestPartResultArray& results);
+    /// Adds the running test to the flakiness statistics
+    inline void RecordAttempts_(int attempts, bool passed);
+#endif
+#if defined(CppUnit2Gtest_EnableForkIsolation)
+    /// Can run each test in a child forked after SetUpTestSuite
+    template<typename TestSuite>
+    struct ManagedTest;
+#endif
+
+    /// Includes the TestBody entry point that gtest runs
+    template<typename TestSuite>
+    struct DynamicTest : TestSuite {
+        using TestSuite::TestSuite;
+        using TestMethod = typename TestData<TestSuite>::TestMethodType;
+        TestMethod testMethod;
+        const TestData<TestSuite>* testData = nullptr;
+#if defined(CppUnit2Gtest_EnablePrioritization) || defined(CppUnit2Gtest_EnableTracing) || defined(CppUnit2Gtest_EnableRetries)
+        // Skips tearDown, also set once a retry has torn the fixture down early
+        bool stopped = false;
+        void SetUp() override {
+#   if defined(CppUnit2Gtest_EnablePrioritization)
+            stopped = StopRequested_();
+            if (stopped) { GTEST_SKIP() << "Stopped, a test failed in another worker"; }
+#   endif
+#   if defined(CppUnit2Gtest_EnableTracing)
+            const TraceScope_ tracing{"test", "setUp"};
+#   endif
+            TestSuite::SetUp();
+        }
+        void TearDown() override {
+            if (stopped) { return; }
+#   if defined(CppUnit2Gtest_EnableTracing)
+            const TraceScope_ tracing{"test", "tearDown"};
+#   endif
+            TestSuite::TearDown();
+        }
+#endif
+#if defined(CppUnit2Gtest_EnableTracing)
+        // gtest finds the suite's SetUpTestSuite and TearDownTestSuite through the registered test
+        static void SetUpTestSuite() {
+            const TraceScope_ tracing{"suite", "SetUpTestSuite " + CurrentSuiteName_()};
+            TestSuite::SetUpTestSuite();
+        }
+        static void TearDownTestSuite() {
+            const TraceScope_ tracing{"suite", "TearDownTestSuite " + CurrentSuiteName_()};
+            TestSuite::TearDownTestSuite();
+        }
+#endif
+        explicit DynamicTest(TestMethod testMethod_) : testMethod(testMethod_) {}
+        // testData_ must outlive the test, the registered factory holds it
+        explicit DynamicTest(const TestData<TestSuite>& testData_)
+            : testMethod(testData_.testMethod), testData(&testData_)
+        {
+#if defined(CppUnit2Gtest_EnableTimeouts)
+            ArmWatchdog_(testData->properties);
+#endif
+        }
+#if defined(CppUnit2Gtest_EnableTimeouts)
+        ~DynamicTest() override { if (testData != nullptr) { DisarmWatchdog_(); } }
+#endif
+        void TestBody() override {
+            RecordTestProperties();
+#if defined(CppUnit2Gtest_EnableRetries)
+            const int retries = testData != nullptr ? Retries_(testData->properties) : 0;
+            if (retries > 0) {
+                RunWithRetries(retries);
+                return;
+            }
+#endif
+            RunTestMethod();
+        }
+        void RecordTestProperties() {
+            if (testData != nullptr) {
+                for (const auto& property : testData->properties) {
+                    if (IsControlProperty_(property.first)) { continue; }
+                    ::testing::Test::RecordProperty(RecordedPropertyName_(property.first), property.second);
+                }
+            }
+        }
+        void RunTestMethod() {
+            // We inherit from this so safe to cast.
+            RunTestMethodOn(static_cast<TestSuite&>(*this));
+        }
+        /// Runs this test's method on the given fixture
+        void RunTestMethodOn(TestSuite& a) {
+#if defined(CppUnit2Gtest_EnablePerfCounters)
+            const PerfCountersScope_ counting{};
+#endif
+#if defined(CppUnit2Gtest_EnableSamplingProfiler)
+            const SamplingScope_ sampling{};
+#endif
+#if defined(CppUnit2Gtest_EnableTracing)
+            const TraceScope_ tracing{"test", "test body"};
+#endif
+            try {
+                if (testData != nullptr && testData->boundMethod) {
+                    testData->boundMethod(a);
+                } else {
+                    (testMethod)(a);
+                }
+            } catch (const ExitingAssertion& e) {
+                // Hack to get around non-exiting assertions
+                //  Mostly only needed when CppUnit2Gtest_AllowAssertsInConstructors is on
+                FAIL() << e.str();
+            }
+        }
+#if defined(CppUnit2Gtest_EnableRetries)
+        /// Runs the test again while it fails and attempts remain. Each retry gets a fresh fixture
+        ///  (constructed, setUp, test and tearDown) but the suite's SetUpTestSuite state is kept.
+        ///  Only the last attempt's results are reported, the earlier ones are recorded as properties
+        void RunWithRetries(const int retries) {
+            RunAttempts(retries, [this](::testing::TestPartResultArray& results) {
+                RunAttemptStage_(results, [this]() { RunTestMethod(); }, "the test body");
+                if (AttemptFailed_(results)) {
+                    // Retried, the fixture gtest made is done with and gtest mustn't tear it down again
+                    RunAttemptStage_(results, [this]() { DynamicTest::TearDown(); }, "TearDown()");
+                    stopped = true;
+                }
+            }, [this](::testing::TestPartResultArray& results) {
+                // Built like gtest builds it, so it has the test's properties and timeout
+                std::unique_ptr<DynamicTest> fresh;
+                RunAttemptStage_(results, [this, &fresh]() { fresh.reset(new DynamicTest{*testData}); }, "the test fixture's constructor");
+                if (!fresh) { return; }
+                RunAttemptStage_(results, [&fresh]() { fresh->DynamicTest::SetUp(); }, "SetUp()");
+                if (!AttemptStopped_(results)) {
+                    RunAttemptStage_(results, [this, &fresh]() { RunTestMethodOn(*fresh); }, "the test body");
+                }
+                RunAttemptStage_(results, [&fresh]() { fresh->DynamicTest::TearDown(); }, "TearDown()");
+                RunAttemptStage_(results, [&fresh]() { fresh.reset(); }, "the test fixture's destructor");
+#   if defined(CppUnit2Gtest_EnableTimeouts)
+                // The retry's fixture disarmed the single watchdog, the rest of the test gets its deadline back
+                ArmWatchdog_(testData->properties);
+#   endif
+            });
+        }
+        /// Runs first then retry while the attempts fail and retries remain, each attempt reports to its results
+        void RunAttempts(const int retries,
+                         const std::function<void(::testing::TestPartResultArray&)>& first,
+                         const std::function<void(::testing::TestPartResultArray&)>& retry) {
+            std::unique_ptr<::testing::TestPartResultArray> results{new ::testing::TestPartResultArray{}};
+            first(*results);
+            int attempts = 1;
+            std::string failures;
+            while (AttemptFailed_(*results) && attempts <= retries) {
+                failures += (failures.empty() ? "" : "\n") + FirstFailure_(*results);
+                results.reset(new ::testing::TestPartResultArray{});
+                ++attempts;
+                retry(*results);
+            }
+            const bool passed = !AttemptFailed_(*results);
+            ::testing::Test::RecordProperty("attempts", attempts);
+            if (attempts > 1) {
+                ::testing::Test::RecordProperty("flaky", passed ? "true" : "false");
+                ::testing::Test::RecordProperty("retried_failures", failures);
+            }
+            RecordAttempts_(attempts, passed);
+            ReportAttempt_(*results);
+        }
+#endif
+    };
+
+    /// Registers a vector of tests from a test suite, can be less or more than overload
+    template<typename TestSuite>
+    size_t InternalRegisterTestsVector(
+        std::vector<TestData<TestSuite>>& testSuiteData,
+        const char* file_name,
+        const int line_number,
+        const char* fixtureName,
+        const char* typeName = nullptr)
+    {
+        // Never occurs with expected usage so safe to assert.
+        CppUnit2Gtest_CHECK(file_name != nullptr);
+        CppUnit2Gtest_CHECK(fixtureName != nullptr);
+#if defined(CppUnit2Gtest_EnableStreamingOutput)
+        InstallStreamingOutput_();
+#endif
+#if defined(CppUnit2Gtest_EnablePerfCounters)
+        InstallPerfCounters_();
+#endif
+#if defined(CppUnit2Gtest_EnablePrioritization)
+        {
+            std::vector<std::string> testNames;
+            for (const auto& testData : testSuiteData) { testNames.emplace_back(testData.testName); }
+            // The copy outlives the caller's vector
+            auto deferredData = testSuiteData;
+            const auto registration = [deferredData, file_name, line_number, fixtureName, typeName]() mutable {
+                InternalRegisterTestsVector(deferredData, file_name, line_number, fixtureName, typeName);
+            };
+            if (DeferRegistration_(fixtureName, std::move(testNames), registration)) { return testSuiteData.size(); }
+        }
+#endif
+        // Options can leave tests out of the run
+        std::vector<const TestData<TestSuite>*> selected;
+        for (const auto& testData : testSuiteData) {
+#if defined(CppUnit2Gtest_EnableImpactSelection)
+            if (!IsImpacted_(fixtureName, testData.testName, testData.file != nullptr ? testData.file : file_name)) { continue; }
+#endif
+            selected.push_back(&testData);
+        }
+#if defined(CppUnit2Gtest_EnablePrioritization)
+        std::stable_sort(selected.begin(), selected.end(), [fixtureName](const TestData<TestSuite>* a, const TestData<TestSuite>* b) {
+            return RunsBefore_(fixtureName, a->testName, b->testName);
+        });
+#endif
+#if defined(CppUnit2Gtest_EnableForkIsolation)
+        using RegisteredTest = ManagedTest<TestSuite>;
+#else
+        using RegisteredTest = DynamicTest<TestSuite>;
+#endif
+#if defined(CppUnit2Gtest_EnableResultCache)
+        std::vector<bool> cachedPasses(selected.size(), false);
+        for (size_t i = 0; i < selected.size(); ++i) {
+            cachedPasses[i] = HasCachedPass_(fixtureName, selected[i]->testName);
+        }
+        // A suite that is entirely cached doesn't need its fixture (or SetUpTestSuite) at all
+        const bool allCached = !cachedPasses.empty() && std::find(cachedPasses.begin(), cachedPasses.end(), false) == cachedPasses.end();
+        if (allCached) {
+            for (const auto* testData : selected) {
+                ::testing::RegisterTest(fixtureName, testData->testName, typeName, nullptr, file_name, line_number,
+                    []() -> CachedPassTest* { return new CachedPassTest{}; });
+            }
+            return testSuiteData.size();
+        }
+#endif
+        for (size_t i = 0; i < selected.size(); ++i)
+        {
+            const auto& testData = *selected[i];
+#if defined(CppUnit2Gtest_EnableScheduling)
+            RecordSchedulingProperties_(fixtureName, testData.testName, testData.properties);
+#endif
+            // Tests added with CPPUNIT_TEST know where they are, otherwise use the registration
+            const bool hasLocation = testData.file != nullptr;
+#if defined(CppUnit2Gtest_EnableResultCache)
+            if (cachedPasses[i]) {
+                ::testing::RegisterTest(fixtureName, testData.testName, typeName, nullptr,
+                    hasLocation ? testData.file : file_name, hasLocation ? static_cast<int>(testData.line) : line_number,
+                    [testData]() -> RegisteredTest* { return new CachedPassFixture<RegisteredTest>(testData); });
+                continue;
+            }
+#endif
+            // Register the test programmatically
+            ::testing::RegisterTest(
+                 fixtureName,              // name of the fixture
+                 testData.testName,        // name of the test
+                 typeName, nullptr,        // argument details for typed and parametrised tests
+                 hasLocation ? testData.file : file_name,                           // For the log
+                 hasLocation ? static_cast<int>(testData.line) : line_number,
+                 // Any callable that returns adress of an object inheriting testing::Test 
+                 [testData]() -> RegisteredTest* {
+#if defined(CppUnit2Gtest_EnableTracing)
+                     const TraceScope_ tracing{"test", "construct fixture"};
+#endif
+                     return new RegisteredTest(testData);
+                 }
+             );
+        }
+        return testSuiteData.size();
+    }
+
+    /// Register required tests from a suite 
+    template<typename TestSuite>
+    size_t InternalRegisterTests(const char* file_name, int line_number, const char* fixtureName, const char* typeName = nullptr)
+    {
+#if defined(CppUnit2Gtest_EnableTracing)
+        const TraceScope_ tracing{"registration", std::string("register ") + fixtureName};
+#endif
+#if defined(CppUnit2Gtest_EnableRegistrationStats)
+        RegistrationStatsScope_ measuring{fixtureName, file_name};
+#endif
+        std::vector<TestData<TestSuite>> tests = TestSuite::GetAllTests_();
+#if defined(CppUnit2Gtest_EnableRegistrationStats)
+        measuring.stats.tests = tests.size();
+#endif
+
+        InternalRegisterTestsVector(tests, file_name, line_number, fixtureName, typeName);
+        // return an int so we can call this statically a bit easier
+        return tests.size();
+    }
+
+    /// Types a templated fixture is registered with by CPPUNIT_TYPED_TEST_SUITE_REGISTRATION
+    template<typename... Types>
+    struct TypeList {};
+
+    /// Keeps a name built at registration alive for gtest and deferred registrations
+    inline const char* KeepName_(std::string name) {
+        static std::vector<std::unique_ptr<const std::string>> names;
+        names.push_back(std::make_unique<const std::string>(std::move(name)));
+        return names.back()->c_str();
+    }
+
+    /// A type's name usable in a gtest filter, "ns::Pair<int, char>" becomes "ns_Pair_int_char"
+    inline std::string FilterSafeName_(const std::string& typeName) {
+        std::string name;
+        for (const char c : typeName) {
+            const bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+            if (word) {
+                name += c;
+            } else if (!name.empty() && name.back() != '_') {
+                name += '_';
+            }
+        }
+        if (!name.empty() && name.back() == '_') { name.pop_back(); }
+        return name;
+    }
+
+    /// Registers Fixture<Type> as the suite "suiteName/Type" with Type shown as its TypeParam
+    template<template<typename...> class Fixture, typename Type>
+    size_t InternalRegisterTypedTests(const char* file_name, const int line_number, const std::string& suiteName) {
+        const std::string typeName = ::testing::internal::GetTypeName<Type>();
+        return InternalRegisterTests<Fixture<Type>>(file_name, line_number,
+            KeepName_(suiteName + "/" + FilterSafeName_(typeName)), KeepName_(typeName));
+    }
+
+    /// Registers a templated fixture for every type of the list in one pass.
+    ///  Suite names only depend on the type, so a list can be split over registrations in several files
+    template<template<typename...> class Fixture, typename... Types>
+    size_t InternalRegisterTypedTests(const char* file_name, const int line_number, const char* suiteName, TypeList<Types...>) {
+        CppUnit2Gtest_CHECK(suiteName != nullptr);
+        const std::string name = suiteName;
+        return (size_t{0} + ... + InternalRegisterTypedTests<Fixture, Types>(file_name, line_number, name));
+    }
+
+#if defined(CppUnit2Gtest_EnableTimeouts)
+/// Default deadline for each test, 0 disables it.
+///  Overridden by the CPPUNIT2GTEST_TIMEOUT_MS environment variable or the "timeout_ms" property
+#   ifndef CppUnit2Gtest_DefaultTimeoutMs
+#       define CppUnit2Gtest_DefaultTimeoutMs 60000
+#   endif
+/// Signal used to ask each thread for its stack when a test times out
+#   ifndef CppUnit2Gtest_StackDumpSignal
+#       define CppUnit2Gtest_StackDumpSignal SIGURG
+#   endif
+
+#   if defined(__linux__) && defined(__GLIBC__)
+    /// One thread's stack, handed from the signal handler to the thread printing it.
+    ///  requested holds the tid asked for, the handler claims it by negating it and clears it when the frames are in
+    struct StackHandoff {
+        std::atomic<long> requested{0};
+        void* frames[64];
+        int frame_count = 0;
+    };
+
+    inline StackHandoff& StackHandoff_() { static StackHandoff handoff; return handoff; }
+
+    inline void DumpStackHandler_(int) {
+        // Only takes the frames, printing (and symbolizing) them is left to DumpAllStacks_.
+        //  backtrace is only unsafe on its first call which loads libgcc, InstallStackDumpHandler_ makes that call
+        StackHandoff& handoff = StackHandoff_();
+        const long tid = syscall(SYS_gettid);
+        long expected = tid;
+        // A thread that answers after DumpAllStacks_ gave up on it must not overwrite the next thread's frames
+        if (!handoff.requested.compare_exchange_strong(expected, -tid)) { return; }
+        handoff.frame_count = backtrace(handoff.frames, 64);
+        handoff.requested = 0;
+    }
+
+    /// Prints the stack of every thread (except the calling one) to stderr, one thread at a time
+    inline void DumpAllStacks_() {
+        DIR* tasks = opendir("/proc/self/task");
+        if (tasks == nullptr) { return; }
+        StackHandoff& handoff = StackHandoff_();
+        const long self = syscall(SYS_gettid);
+        while (const dirent* task = readdir(tasks)) {
+            const long tid = std::strtol(task->d_name, nullptr, 10);
+            if (tid <= 0 || tid == self) { continue; }
+            handoff.requested = tid;
+            if (syscall(SYS_tgkill, getpid(), tid, CppUnit2Gtest_StackDumpSignal) != 0) { handoff.requested = 0; continue; }
+            // Don't wait forever on a thread that is blocking signals
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            while (handoff.requested != 0 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            long expected = tid;
+            if (handoff.requested.compare_exchange_strong(expected, 0)) {
+                std::cerr << "--- Thread " << tid << " did not respond ---" << std::endl;
+                continue;
+            }
+            // It may still be taking its frames
+            while (handoff.requested != 0) { std::this_thread::yield(); }
+            std::cerr << "--- Stack of thread " << tid << " ---" << std::endl;
+            backtrace_symbols_fd(handoff.frames, handoff.frame_count, STDERR_FILENO);
+        }
+        closedir(tasks);
+    }
+
+    inline void InstallStackDumpHandler_() {
+        void* frames[1];
+        (void)backtrace(frames, 1); // Loads libgcc now, it isn't safe to do in a signal handler
+        struct sigaction action {};
+        action.sa_handler = &DumpStackHandler_;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        sigaction(CppUnit2Gtest_StackDumpSignal, &action, nullptr);
+    }
+#   else
+    inline void DumpAllStacks_() { std::cerr << "Stack capture is not supported on this platform\n"; }
+    inline void InstallStackDumpHandler_() {}
+#   endif
+
+    inline std::chrono::milliseconds DefaultTimeout_() {
+        const char* timeout = std::getenv("CPPUNIT2GTEST_TIMEOUT_MS");
+        return std::chrono::milliseconds(timeout != nullptr ? std::atoll(timeout) : CppUnit2Gtest_DefaultTimeoutMs);
+    }
+
+    /// Thread that enforces a deadline on the currently running test. A hung test can't be stopped
+    ///  within the process so the run is aborted, fork isolated tests are killed and failed instead
+    struct Watchdog {
+        static Watchdog& Instance() {
+            // Deliberately leaked, a forked child (i.e. exiting from a forked test) would wait forever for the thread
+            static Watchdog* watchdog = new Watchdog{};
+            return *watchdog;
+        }
+
+        Watchdog() { InstallStackDumpHandler_(); }
+        Watchdog(const Watchdog&) = delete;
+        Watchdog& operator=(const Watchdog&) = delete;
+        ~Watchdog() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            if (thread.joinable()) { thread.join(); }
+        }
+
+        /// Starts the clock on a test, zero disarms
+        void Arm(std::string testName_, const std::chrono::milliseconds timeout_) {
+            std::lock_guard<std::mutex> lock(mutex);
+            armed = timeout_.count() > 0;
+            testName = std::move(testName_);
+            timeout = timeout_;
+            deadline = std::chrono::steady_clock::now() + timeout_;
+            ++generation;
+            if (armed && !thread.joinable()) { thread = std::thread([this] { Watch(); }); }
+            wake.notify_all();
+        }
+
+        void Disarm() {
+            std::lock_guard<std::mutex> lock(mutex);
+            armed = false;
+            ++generation;
+        }
+
+        [[nodiscard]] bool Armed() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return armed;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::thread thread;
+        bool armed = false;
+        bool stopping = false;
+        unsigned long generation = 0;
+        std::string testName;
+        std::chrono::milliseconds timeout{0};
+        std::chrono::steady_clock::time_point deadline;
+
+        void Watch() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                if (!armed) { wake.wait(lock); continue; }
+                const auto watching = generation;
+                if (wake.wait_until(lock, deadline) == std::cv_status::timeout && armed && watching == generation) {
+                    // Keep the lock so the test cannot finish (disarm) while it is being reported
+                    Expire();
+                    armed = false;
+                }
+            }
+        }
+
+        void Expire() {
+            std::cerr << "[ TIMEOUT  ] " << testName << " exceeded " << timeout.count() << " ms\n" << std::flush;
+            DumpAllStacks_();
+            std::cerr << "[  FAILED  ] " << testName << " (timed out, aborting)" << std::endl;
+            const std::string reason = "timed out after " + std::to_string(timeout.count()) + " ms";
+            // gtest writes its --gtest_output report at the end of the run, which never comes.
+            //  Fail the test (from this thread the failure goes to the running test) and have it written now
+            ::testing::UnitTest& unitTest = *::testing::UnitTest::GetInstance();
+            if (unitTest.current_test_info() != nullptr) {
+                ADD_FAILURE() << testName << " " << reason;
+                if (const auto report = unitTest.listeners().default_xml_generator()) {
+                    report->OnTestIterationEnd(unitTest, 0);
+                }
+            }
+            for (const auto handler : AbortHandlers_()) {
+                handler(testName, reason);
+            }
+            std::abort();
+        }
+    };
+
+    inline void ArmWatchdog_(const Properties& properties) {
+        const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        if (info == nullptr) { return; }
+        const std::string* property = FindProperty(properties, "timeout_ms");
+        const auto timeout = property != nullptr ? std::chrono::milliseconds(std::atoll(property->c_str())) : DefaultTimeout_();
+        Watchdog::Instance().Arm(std::string{info->test_suite_name()} + "." + info->name(), timeout);
+    }
+
+    inline void DisarmWatchdog_() { Watchdog::Instance().Disarm(); }
+#endif // CppUnit2Gtest_EnableTimeouts
+
+#if defined(CppUnit2Gtest_EnableStreamingOutput)
+/// Bytes of results held in memory before they are written out
+#   ifndef CppUnit2Gtest_StreamingChunkBytes
+#       define CppUnit2Gtest_StreamingChunkBytes 65536
+#   endif
+
+    /// Escapes text for use in xml (and isn't far off for json)
+    inline std::string XmlEscape_(const std::string& text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const char c : text) {
+            switch (c) {
+                case '<': escaped += "&lt;"; break;
+                case '>': escaped += "&gt;"; break;
+                case '&': escaped += "&amp;"; break;
+                case '"': escaped += "&quot;"; break;
+                case '\'': escaped += "&apos;"; break;
+                case '\n': escaped += "&#10;"; break;
+                default: if (static_cast<unsigned char>(c) >= 0x20 || c == '\t') { escaped += c; }
+            }
+        }
+        return escaped;
+    }
+
+    inline std::string JsonEscape_(const std::string& text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const char c : text) {
+            switch (c) {
+                case '"': escaped += "\\\""; break;
+                case '\\': escaped += "\\\\"; break;
+                case '\n': escaped += "\\n"; break;
+                case '\t': escaped += "\\t"; break;
+                default: if (static_cast<unsigned char>(c) >= 0x20) { escaped += c; }
+            }
+        }
+        return escaped;
+    }
+
+    /// A single failed assertion (or uncaught exception) of a test
+    struct StreamedFailure {
+        bool isError; // CppUnit distinguishes exceptions (errors) from assertions (failures)
+        std::string file;
+        int line;
+        std::string message;
+    };
+
+    /// Writes results in the format of CppUnit's XmlOutputter as each test finishes, with an
+    ///  optional json lines companion. Only the unwritten chunk is held in memory.
+    ///  The file is kept well formed after every write by writing the closing tags after the
+    ///  last result and overwriting them with the next chunk. Results are written one per line
+    ///  in the order they finish, so the sections can repeat. `Finish` rewrites the file (one
+    ///  line at a time) with a single FailedTests and SuccessfulTests section like CppUnit's.
+    ///  Forked processes (i.e. death tests) never write to the parent's stream.
+    struct CppUnitXmlStream {
+        explicit CppUnitXmlStream(std::string xmlPath_, const std::string& jsonPath = "")
+            : xmlPath(std::move(xmlPath_))
+        {
+            if (!xmlPath.empty()) {
+                xml.open(xmlPath, std::ios::out | std::ios::trunc);
+                if (!xml) { throw std::runtime_error("Cannot open CppUnit xml output: " + xmlPath); }
+                xml << "<?xml version=\"1.0\" encoding='ISO-8859-1' standalone='yes' ?>\n<TestRun>\n";
+                tailPosition = xml.tellp();
+                WriteTail();
+            }
+            if (!jsonPath.empty()) {
+                json.open(jsonPath, std::ios::out | std::ios::trunc);
+                if (!json) { throw std::runtime_error("Cannot open json lines output: " + jsonPath); }
+            }
+        }
+
+        void AddTest(const std::string& suite, const std::string& test,
+                     const std::vector<StreamedFailure>& failures, const bool skipped = false, const long long timeMs = 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (finished || !IsOwner()) { return; }
+            const int id = ++tests;
+            const std::string name = suite + "::" + test;
+            const bool isError = !failures.empty() && failures.front().isError;
+            if (xml.is_open()) {
+                const char* section = failures.empty() ? "SuccessfulTests" : "FailedTests";
+                if (openSection != section) {
+                    if (openSection != nullptr) { xmlChunk += std::string{"</"} + openSection + ">\n"; }
+                    xmlChunk += std::string{"<"} + section + ">\n";
+                    openSection = section;
+                }
+                if (failures.empty()) {
+                    xmlChunk += "<Test id=\"" + std::to_string(id) + "\"><Name>" + XmlEscape_(name) + "</Name></Test>\n";
+                } else {
+                    // CppUnit only reports the first failure, keep the rest in the message
+                    std::string message;
+                    for (const auto& failure : failures) { message += failure.message + "\n"; }
+                    xmlChunk += "<FailedTest id=\"" + std::to_string(id) + "\"><Name>" + XmlEscape_(name)
+                        + "</Name><FailureType>" + (isError ? "Error" : "Assertion") + "</FailureType>"
+                        + "<Location><File>" + XmlEscape_(failures.front().file) + "</File><Line>"
+                        + std::to_string(failures.front().line) + "</Line></Location><Message>"
+                        + XmlEscape_(message) + "</Message></FailedTest>\n";
+                }
+            }
+            if (!failures.empty()) { ++(isError ? errors : assertionFailures); }
+            if (json.is_open()) {
+                jsonChunk += "{\"id\":" + std::to_string(id) + ",\"name\":\"" + JsonEscape_(name)
+                    + "\",\"suite\":\"" + JsonEscape_(suite) + "\",\"test\":\"" + JsonEscape_(test)
+                    + "\",\"result\":\"" + (failures.empty() ? (skipped ? "skipped" : "passed") : (isError ? "error" : "failed"))
+                    + "\",\"time_ms\":" + std::to_string(timeMs) + ",\"failures\":[";
+                for (size_t i = 0; i < failures.size(); ++i) {
+                    jsonChunk += std::string{i == 0 ? "" : ","} + "{\"file\":\"" + JsonEscape_(failures[i].file)
+                        + "\",\"line\":" + std::to_string(failures[i].line)
+                        + ",\"message\":\"" + JsonEscape_(failures[i].message) + "\"}";
+                }
+                jsonChunk += "]}\n";
+            }
+            // Failures are written straight away so they survive a crash
+            if (!failures.empty() || xmlChunk.size() + jsonChunk.size() >= CppUnit2Gtest_StreamingChunkBytes) {
+                FlushLocked();
+            }
+        }
+
+        void Flush() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (IsOwner()) { FlushLocked(); }
+        }
+
+        /// Writes everything out and rewrites the xml so it has one section of each kind
+        void Finish() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (finished || !IsOwner()) { return; }
+            FlushLocked();
+            finished = true;
+            json.close();
+            if (!xml.is_open()) { return; }
+            xml.close();
+            const std::string temporaryPath = xmlPath + ".tmp";
+            {
+                std::ofstream canonical(temporaryPath, std::ios::out | std::ios::trunc);
+                canonical << "<?xml version=\"1.0\" encoding='ISO-8859-1' standalone='yes' ?>\n<TestRun>\n";
+                CopyLinesStartingWith(canonical, "<FailedTests>\n", "<FailedTest ", "</FailedTests>\n");
+                CopyLinesStartingWith(canonical, "<SuccessfulTests>\n", "<Test ", "</SuccessfulTests>\n");
+                canonical << Statistics() << "</TestRun>\n";
+                if (!canonical) { return; } // The streamed file is still valid
+            }
+            std::remove(xmlPath.c_str());
+            std::rename(temporaryPath.c_str(), xmlPath.c_str());
+        }
+
+    private:
+        std::mutex mutex;
+        std::string xmlPath;
+        std::ofstream xml;
+        std::ofstream json;
+        std::string xmlChunk;
+        std::string jsonChunk;
+        std::streampos tailPosition{};
+        const char* openSection = nullptr;
+        int tests = 0;
+        int errors = 0;
+        int assertionFailures = 0;
+        bool finished = false;
+        const long ownerProcess = static_cast<long>(CppUnit2Gtest_getpid_());
+
+        bool IsOwner() const { return ownerProcess == static_cast<long>(CppUnit2Gtest_getpid_()); }
+
+        std::string Statistics() const {
+            return "<Statistics><Tests>" + std::to_string(tests) + "</Tests><FailuresTotal>"
+                + std::to_string(errors + assertionFailures) + "</FailuresTotal><Errors>" + std::to_string(errors)
+                + "</Errors><Failures>" + std::to_string(assertionFailures) + "</Failures></Statistics>\n";
+        }
+
+        void WriteTail() {
+            if (openSection != nullptr) { xml << "</" << openSection << ">\n"; }
+            xml << Statistics() << "</TestRun>\n" << std::flush;
+        }
+
+        void FlushLocked() {
+            if (xml.is_open() && !xmlChunk.empty()) {
+                // The file only grows so the old tail is always completely overwritten
+                xml.seekp(tailPosition);
+                xml << xmlChunk;
+                tailPosition = xml.tellp();
+                WriteTail();
+                xmlChunk.clear();
+            }
+            if (json.is_open() && !jsonChunk.empty()) {
+                json << jsonChunk << std::flush;
+                jsonChunk.clear();
+            }
+        }
+
+        void CopyLinesStartingWith(std::ostream& out, const char* open, const char* prefix, const char* close) const {
+            std::ifstream streamed(xmlPath);
+            std::string line;
+            out << open;
+            while (std::getline(streamed, line)) {
+                if (line.compare(0, std::strlen(prefix), prefix) == 0) { out << line << '\n'; }
+            }
+            out << close;
+        }
+    };
+
+    /// True for the failure gtest reports when a test throws, CppUnit counts those as errors
+    inline bool IsExceptionFailure_(const std::string& message) {
+        for (const char* prefix : {"C++ exception with description ", "Unknown C++ exception thrown in ", "SEH exception with code "}) {
+            if (message.compare(0, std::strlen(prefix), prefix) == 0) { return true; }
+        }
+        return false;
+    }
+
+    /// Feeds gtest's results into a CppUnitXmlStream
+    struct StreamingOutputListener : ::testing::EmptyTestEventListener {
+        CppUnitXmlStream& stream;
+        explicit StreamingOutputListener(CppUnitXmlStream& stream_) : stream(stream_) {}
+
+        void OnTestEnd(const ::testing::TestInfo& info) override {
+            const ::testing::TestResult& result = *info.result();
+            std::vector<StreamedFailure> failures;
+            for (int i = 0; i < result.total_part_count(); ++i) {
+                const ::testing::TestPartResult& part = result.GetTestPartResult(i);
+                if (!part.failed()) { continue; }
+                const std::string message = part.message();
+                failures.push_back({IsExceptionFailure_(message), part.file_name() != nullptr ? part.file_name() : "", part.line_number(), message});
+            }
+            stream.AddTest(info.test_suite_name(), info.name(), failures, result.Skipped(), result.elapsed_time());
+        }
+
+        void OnTestProgramEnd(const ::testing::UnitTest&) override { stream.Finish(); }
+    };
+
+    /// The stream configured by CPPUNIT2GTEST_XML_OUTPUT and CPPUNIT2GTEST_JSONL_OUTPUT (or nullptr)
+    inline CppUnitXmlStream* EnvironmentStream_() {
+        static CppUnitXmlStream* stream = []() -> CppUnitXmlStream* {
+            const char* xmlPath = std::getenv("CPPUNIT2GTEST_XML_OUTPUT");
+            const char* jsonPath = std::getenv("CPPUNIT2GTEST_JSONL_OUTPUT");
+            if (xmlPath == nullptr && jsonPath == nullptr) { return nullptr; }
+            // Deliberately leaked, it is used until the very end of the program
+            return new CppUnitXmlStream(xmlPath != nullptr ? xmlPath : "", jsonPath != nullptr ? jsonPath : "");
+        }();
+        return stream;
+    }
+
+    inline void InstallStreamingOutput_() {
+        static const bool installed = []() {
+            if (EnvironmentStream_() == nullptr) { return false; }
+            ::testing::UnitTest::GetInstance()->listeners().Append(new StreamingOutputListener(*EnvironmentStream_()));
+            AbortHandlers_().push_back([](const std::string& testName, const std::string& reason) {
+                const auto dot = testName.find('.');
+                EnvironmentStream_()->AddTest(testName.substr(0, dot), testName.substr(dot + 1), {{true, "", 0, reason}});
+                EnvironmentStream_()->Finish();
+            });
+            return true;
+        }();
+        (void)installed;
+    }
+#endif // CppUnit2Gtest_EnableStreamingOutput
+
+#if defined(CppUnit2Gtest_EnableResultCache)
+    /// 64 bit FNV-1a, good enough to tell binaries and test names apart
+    inline std::uint64_t Fnv1a_(const std::string& data, std::uint64_t hash = 14695981039346656037ull) {
+        for (const char c : data) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline std::string ToHex_(const std::uint64_t value) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(16, '0');
+        for (size_t i = 0; i < 16; ++i) { hex[15 - i] = digits[(value >> (4 * i)) & 0xf]; }
+        return hex;
+    }
+
+#   if defined(__GLIBC__)
+    inline int AppendBuildId_(dl_phdr_info* info, size_t, void* data) {
+        auto& identity = *static_cast<std::string*>(data);
+        for (int i = 0; i < info->dlpi_phnum; ++i) {
+            const auto& header = info->dlpi_phdr[i];
+            if (header.p_type != PT_NOTE) { continue; }
+            const char* note = reinterpret_cast<const char*>(info->dlpi_addr + header.p_vaddr);
+            const char* const end = note + header.p_memsz;
+            while (note + sizeof(ElfW(Nhdr)) <= end) {
+                const auto* noteHeader = reinterpret_cast<const ElfW(Nhdr)*>(note);
+                const char* name = note + sizeof(ElfW(Nhdr));
+                const char* description = name + ((noteHeader->n_namesz + 3u) & ~3u);
+                if (noteHeader->n_type == NT_GNU_BUILD_ID && noteHeader->n_namesz == 4 && std::memcmp(name, "GNU", 4) == 0) {
+                    identity.append(description, noteHeader->n_descsz);
+                }
+                note = description + ((noteHeader->n_descsz + 3u) & ~3u);
+            }
+        }
+        return 0;
+    }
+#   endif
+
+    /// Identifies the code being tested: the build ids of the executable and every library
+    ///  loaded with it, or the contents of the executable when there are no build ids
+    inline std::string BinaryIdentity_() {
+        std::string identity;
+#   if defined(__GLIBC__)
+        dl_iterate_phdr(&AppendBuildId_, &identity);
+#   endif
+        if (identity.empty()) {
+            std::ifstream executable("/proc/self/exe", std::ios::binary);
+            std::string buffer(1 << 16, '\0');
+            std::uint64_t hash = Fnv1a_("");
+            while (executable.read(&buffer[0], static_cast<std::streamsize>(buffer.size())) || executable.gcount() > 0) {
+                hash = Fnv1a_(buffer.substr(0, static_cast<size_t>(executable.gcount())), hash);
+            }
+            identity = ToHex_(hash);
+        }
+        return identity;
+    }
+
+    /// Stores an (empty) file per passing test, named by a hash of everything that could change the result.
+    ///  Entries are touched when used and the least recently used are removed past maxEntries.
+    struct ResultCache {
+        ResultCache(std::string directory_, const std::string& identity, const std::string& environmentNames, const size_t maxEntries_)
+            : directory(std::move(directory_)), maxEntries(maxEntries_)
+        {
+            CreateDirectories(directory);
+            std::string keyBase = identity;
+            size_t start = 0;
+            while (start <= environmentNames.size()) {
+                const auto end = std::min(environmentNames.find(',', start), environmentNames.size());
+                const std::string name = environmentNames.substr(start, end - start);
+                const char* value = name.empty() ? nullptr : std::getenv(name.c_str());
+                keyBase += '\0' + name + '=' + (value != nullptr ? value : "");
+                start = end + 1;
+            }
+            baseHash = Fnv1a_(keyBase);
+        }
+
+        std::string Key(const std::string& suite, const std::string& test) const {
+            return ToHex_(Fnv1a_(suite + '\0' + test, baseHash));
+        }
+
+        /// Remembers the key for the test so a pass can be stored, returns if it has passed before
+        bool Lookup(const std::string& suite, const std::string& test) {
+            const std::string key = Key(suite, test);
+            std::lock_guard<std::mutex> lock(mutex);
+            keys[suite + "." + test] = key;
+            // Touching it marks it as recently used
+            return utime(EntryPath(key).c_str(), nullptr) == 0;
+        }
+
+        void StorePass(const std::string& suite, const std::string& test) {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto found = keys.find(suite + "." + test);
+            if (found == keys.end()) { return; }
+            std::ofstream entry(EntryPath(found->second), std::ios::out | std::ios::trunc);
+            entry << suite << "." << test << "\n";
+        }
+
+        /// Removes the least recently used entries
+        void Evict() const {
+            DIR* entries = opendir(directory.c_str());
+            if (entries == nullptr) { return; }
+            std::vector<std::pair<time_t, std::string>> byAge;
+            while (const dirent* entry = readdir(entries)) {
+                struct stat status {};
+                const std::string path = directory + "/" + entry->d_name;
+                if (entry->d_name[0] != '.' && stat(path.c_str(), &status) == 0 && S_ISREG(status.st_mode)) {
+                    byAge.emplace_back(status.st_mtime, path);
+                }
+            }
+            closedir(entries);
+            if (byAge.size() <= maxEntries) { return; }
+            std::sort(byAge.begin(), byAge.end());
+            for (size_t i = 0; i < byAge.size() - maxEntries; ++i) {
+                std::remove(byAge[i].second.c_str());
+            }
+        }
+
+    private:
+        std::mutex mutex;
+        std::string directory;
+        size_t maxEntries;
+        std::uint64_t baseHash = 0;
+        std::map<std::string, std::string> keys;
+
+        std::string EntryPath(const std::string& key) const { return directory + "/" + key; }
+
+        static void CreateDirectories(const std::string& path) {
+            for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+                mkdir(path.substr(0, slash).c_str(), 0755);
+                if (slash == std::string::npos) { break; }
+            }
+        }
+    };
+
+    /// Records passes into the cache and evicts old entries at the end of the run
+    struct ResultCacheListener : ::testing::EmptyTestEventListener {
+        ResultCache& cache;
+        explicit ResultCacheListener(ResultCache& cache_) : cache(cache_) {}
+
+        void OnTestEnd(const ::testing::TestInfo& info) override {
+            if (info.result()->Passed() && !info.result()->Skipped()) {
+                cache.StorePass(info.test_suite_name(), info.name());
+            }
+        }
+
+        void OnTestProgramEnd(const ::testing::UnitTest&) override { cache.Evict(); }
+    };
+
+    /// The cache in CPPUNIT2GTEST_CACHE_DIR, keyed on the environment variables named in
+    ///  CPPUNIT2GTEST_CACHE_ENV (comma separated), keeping CPPUNIT2GTEST_CACHE_MAX_ENTRIES entries
+    inline ResultCache* EnvironmentResultCache_() {
+        static ResultCache* cache = []() -> ResultCache* {
+            const char* directory = std::getenv("CPPUNIT2GTEST_CACHE_DIR");
+            if (directory == nullptr || *directory == '\0') { return nullptr; }
+            const char* environmentNames = std::getenv("CPPUNIT2GTEST_CACHE_ENV");
+            const char* maxEntries = std::getenv("CPPUNIT2GTEST_CACHE_MAX_ENTRIES");
+            // Deliberately leaked, used until the end of the program
+            auto* created = new ResultCache(directory, BinaryIdentity_(), environmentNames != nullptr ? environmentNames : "",
+                maxEntries != nullptr ? static_cast<size_t>(std::strtoull(maxEntries, nullptr, 10)) : 10000);
+            ::testing::UnitTest::GetInstance()->listeners().Append(new ResultCacheListener(*created));
+            return created;
+        }();
+        return cache;
+    }
+
+    inline bool HasCachedPass_(const std::string& suite, const std::string& test) {
+        ResultCache* cache = EnvironmentResultCache_();
+        return cache != nullptr && cache->Lookup(suite, test);
+    }
+#endif // CppUnit2Gtest_EnableResultCache
+
+#if defined(CppUnit2Gtest_EnableImpactSelection)
+#   if defined(__GNUC__)
+    // Provided by clang's -fprofile-instr-generate runtime, null otherwise
+    extern "C" {
+        int __llvm_profile_write_file(void) __attribute__((weak));
+        void __llvm_profile_set_filename(const char*) __attribute__((weak));
+        void __llvm_profile_reset_counters(void) __attribute__((weak));
+    }
+#   endif
+
+    /// Writes the llvm profile of each test to its own file in CPPUNIT2GTEST_PROFILE_DIR
+    ///  (named Suite.test.profraw), which cmake/CppUnit2GtestCoverageMap.cmake turns into a coverage map
+    struct ProfilePerTestListener : ::testing::EmptyTestEventListener {
+        std::string directory;
+        explicit ProfilePerTestListener(std::string directory_) : directory(std::move(directory_)) {}
+
+        static bool Available() {
+#   if defined(__GNUC__)
+            return &__llvm_profile_write_file != nullptr && &__llvm_profile_set_filename != nullptr
+                && &__llvm_profile_reset_counters != nullptr;
+#   else
+            return false;
+#   endif
+        }
+
+        void OnTestStart(const ::testing::TestInfo&) override { Reset(); }
+
+        void OnTestEnd(const ::testing::TestInfo& info) override {
+            std::string name = std::string{info.test_suite_name()} + "." + info.name();
+            std::replace(name.begin(), name.end(), '/', '_');
+            Write(directory + "/" + name + ".profraw");
+        }
+
+        // Whatever runs after the tests shouldn't be added to the last test
+        void OnTestProgramEnd(const ::testing::UnitTest&) override {
+            Reset();
+            filename = directory + "/after_tests.profraw";
+            Rename();
+        }
+
+    private:
+        std::string filename;
+
+        static void Reset() {
+#   if defined(__GNUC__)
+            __llvm_profile_reset_counters();
+#   endif
+        }
+        void Rename() const {
+#   if defined(__GNUC__)
+            __llvm_profile_set_filename(filename.c_str());
+#   endif
+        }
+        void Write(std::string filename_) {
+            // The runtime keeps the pointer so the string must outlive the call
+            filename = std::move(filename_);
+            Rename();
+#   if defined(__GNUC__)
+            __llvm_profile_write_file();
+#   endif
+        }
+    };
+
+    /// Chooses the tests affected by a set of changed files using the files each test covered
+    struct ImpactSelection {
+        using CoverageMap = std::map<std::string, std::vector<std::string>>;
+        std::vector<std::string> changedFiles;
+        CoverageMap coverage;
+        size_t selectedCount = 0;
+        size_t totalCount = 0;
+
+        ImpactSelection(std::vector<std::string> changedFiles_, CoverageMap coverage_)
+            : changedFiles(std::move(changedFiles_)), coverage(std::move(coverage_)) {}
+
+        /// Paths are often relative to different places so a trailing match is enough
+        static bool SamePath(const std::string& a, const std::string& b) {
+            const std::string& shorter = a.size() < b.size() ? a : b;
+            const std::string& longer = a.size() < b.size() ? b : a;
+            if (shorter.empty()) { return false; }
+            if (longer.size() == shorter.size()) { return longer == shorter; }
+            return longer.compare(longer.size() - shorter.size(), shorter.size(), shorter) == 0
+                && (longer[longer.size() - shorter.size() - 1] == '/' || longer[longer.size() - shorter.size() - 1] == '\\');
+        }
+
+        bool Changed(const std::string& file) const {
+            return std::any_of(changedFiles.begin(), changedFiles.end(),
+                [&file](const std::string& changed) { return SamePath(changed, file); });
+        }
+
+        /// A test runs if its own file changed, it covered a changed file or it isn't in the map
+        bool IsImpacted(const std::string& suite, const std::string& test, const std::string& file) {
+            ++totalCount;
+            const auto covered = coverage.find(suite + "." + test);
+            const bool impacted = Changed(file) || covered == coverage.end()
+                || std::any_of(covered->second.begin(), covered->second.end(), [this](const std::string& f) { return Changed(f); });
+            selectedCount += impacted ? 1 : 0;
+            return impacted;
+        }
+
+        /// Lines of "Suite.test<tab>file<tab>file..."
+        static CoverageMap ReadCoverageMap(std::istream& in) {
+            CoverageMap map;
+            std::string line;
+            while (std::getline(in, line)) {
+                std::vector<std::string> fields;
+                size_t start = 0;
+                for (size_t tab = line.find('\t'); ; tab = line.find('\t', start)) {
+                    fields.push_back(line.substr(start, tab - start));
+                    if (tab == std::string::npos) { break; }
+                    start = tab + 1;
+                }
+                if (fields.front().empty()) { continue; }
+                auto& files = map[fields.front()];
+                files.insert(files.end(), fields.begin() + 1, fields.end());
+            }
+            return map;
+        }
+
+        /// One file per line, i.e. from `git diff --name-only`
+        static std::vector<std::string> ReadChangedFiles(std::istream& in) {
+            std::vector<std::string> files;
+            std::string line;
+            while (std::getline(in, line)) {
+                if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+                if (!line.empty()) { files.push_back(line); }
+            }
+            return files;
+        }
+    };
+
+    /// Prints how many tests impact selection kept
+    struct ImpactSelectionListener : ::testing::EmptyTestEventListener {
+        const ImpactSelection& selection;
+        explicit ImpactSelectionListener(const ImpactSelection& selection_) : selection(selection_) {}
+        void OnTestProgramStart(const ::testing::UnitTest&) override {
+            std::cout << "[ IMPACT   ] Running " << selection.selectedCount << " of " << selection.totalCount
+                      << " CppUnit tests affected by " << selection.changedFiles.size() << " changed files\n";
+        }
+    };
+
+    /// Selection from CPPUNIT2GTEST_CHANGED_FILES and CPPUNIT2GTEST_COVERAGE_MAP (both file paths), or nullptr
+    inline ImpactSelection* EnvironmentImpactSelection_() {
+        static ImpactSelection* selection = []() -> ImpactSelection* {
+            const char* profileDirectory = std::getenv("CPPUNIT2GTEST_PROFILE_DIR");
+            if (profileDirectory != nullptr) {
+                if (ProfilePerTestListener::Available()) {
+                    ::testing::UnitTest::GetInstance()->listeners().Append(new ProfilePerTestListener(profileDirectory));
+                } else {
+                    std::cerr << "CPPUNIT2GTEST_PROFILE_DIR is set but the tests weren't built with -fprofile-instr-generate\n";
+                }
+            }
+            const char* changedPath = std::getenv("CPPUNIT2GTEST_CHANGED_FILES");
+            const char* mapPath = std::getenv("CPPUNIT2GTEST_COVERAGE_MAP");
+            if (changedPath == nullptr || mapPath == nullptr) { return nullptr; }
+            std::ifstream changed(changedPath);
+            std::ifstream map(mapPath);
+            if (!changed || !map) {
+                std::cerr << "Cannot read CPPUNIT2GTEST_CHANGED_FILES or CPPUNIT2GTEST_COVERAGE_MAP, running every test\n";
+                return nullptr;
+            }
+            // Deliberately leaked, the listener uses it until the end of the program
+            auto* created = new ImpactSelection(ImpactSelection::ReadChangedFiles(changed), ImpactSelection::ReadCoverageMap(map));
+            ::testing::UnitTest::GetInstance()->listeners().Append(new ImpactSelectionListener(*created));
+            return created;
+        }();
+        return selection;
+    }
+
+    inline bool IsImpacted_(const std::string& suite, const std::string& test, const std::string& file) {
+        ImpactSelection* selection = EnvironmentImpactSelection_();
+        return selection == nullptr || selection->IsImpacted(suite, test, file);
+    }
+#endif // CppUnit2Gtest_EnableImpactSelection
+
+#if defined(CppUnit2Gtest_EnablePrioritization)
+    /// Recent failures and runtimes of each test ("Suite.test")
+    struct TestHistory {
+        /// Failures older than this many runs are forgotten, as are tests that didn't run for as long
+        static constexpr unsigned long window = 32;
+        struct Entry {
+            unsigned long lastRun = 0;
+            /// Bit n is set if the test failed n runs before lastRun
+            unsigned long long failures = 0;
+            long long durationMs = 0;
+        };
+        /// Sorts first for tests that failed most recently, then for the fastest
+        struct Priority {
+            unsigned long runsSinceFailure;
+            long long durationMs;
+            bool operator<(const Priority& other) const {
+                return std::tie(runsSinceFailure, durationMs) < std::tie(other.runsSinceFailure, other.durationMs);
+            }
+        };
+
+        std::map<std::string, Entry> entries;
+        /// Number of the current run
+        unsigned long run = 1;
+
+        void Record(const std::string& test, const bool failed, const long long durationMs) {
+            auto& entry = entries[test];
+            const unsigned long age = run - entry.lastRun;
+            entry.failures = (entry.lastRun == 0 || entry.lastRun > run || age >= window) ? 0 : (entry.failures << age) & ((1ULL << window) - 1);
+            entry.failures |= failed ? 1ULL : 0ULL;
+            entry.lastRun = run;
+            entry.durationMs = durationMs;
+        }
+
+        Priority PriorityOf(const std::string& test) const {
+            const auto found = entries.find(test);
+            if (found == entries.end()) { return {window, 0}; }
+            const Entry& entry = found->second;
+            Priority priority{window, entry.durationMs};
+            for (unsigned long bit = 0; bit < window; ++bit) {
+                if ((entry.failures >> bit) & 1ULL) {
+                    priority.runsSinceFailure = std::min(window, run - 1 - entry.lastRun + bit);
+                    break;
+                }
+            }
+            return priority;
+        }
+
+        /// A "run N" line then lines of "Suite.test<tab>lastRun<tab>failures<tab>durationMs", the next run is N+1
+        void Load(std::istream& in) {
+            std::string word;
+            unsigned long lastRun = 0;
+            if (!(in >> word >> lastRun) || word != "run") { return; }
+            run = lastRun + 1;
+            std::string test;
+            Entry entry;
+            while (in >> test >> entry.lastRun >> entry.failures >> entry.durationMs) {
+                entries[test] = entry;
+            }
+        }
+
+        void Save(std::ostream& out) const {
+            out << "run " << run << '\n';
+            for (const auto& entry : entries) {
+                if (entry.second.lastRun + window <= run) { continue; }
+                out << entry.first << '\t' << entry.second.lastRun << '\t' << entry.second.failures << '\t' << entry.second.durationMs << '\n';
+            }
+        }
+    };
+
+    /// Orders CppUnit suites by their history and stops runs early, see EnvironmentPrioritizer_
+    struct Prioritizer {
+        struct DeferredSuite {
+            std::string name;
+            std::vector<std::string> testNames;
+            std::function<void()> registration;
+        };
+        struct Result {
+            std::string test;
+            bool failed;
+            long long durationMs;
+        };
+
+        std::string historyPath;
+        std::string stopPath;
+        bool failFast = false;
+        TestHistory history;
+        std::vector<DeferredSuite> deferred;
+        std::vector<Result> results;
+        bool registered = false;
+
+        Prioritizer(std::string historyPath_, std::string stopPath_, const bool failFast_)
+            : historyPath(std::move(historyPath_)), stopPath(std::move(stopPath_)), failFast(failFast_)
+        {
+            std::ifstream in(historyPath);
+            history.Load(in);
+        }
+
+        bool Defer(DeferredSuite suite) {
+            if (registered || historyPath.empty()) { return false; }
+            deferred.push_back(std::move(suite));
+            return true;
+        }
+
+        TestHistory::Priority PriorityOf(const DeferredSuite& suite) const {
+            // The suite runs as a whole so it is as urgent as its most urgent test and as slow as all of them
+            TestHistory::Priority priority{TestHistory::window, 0};
+            for (const auto& test : suite.testNames) {
+                const auto testPriority = history.PriorityOf(suite.name + "." + test);
+                priority.runsSinceFailure = std::min(priority.runsSinceFailure, testPriority.runsSinceFailure);
+                priority.durationMs += testPriority.durationMs;
+            }
+            return priority;
+        }
+
+        void RegisterDeferred() {
+            registered = true;
+            std::vector<DeferredSuite> suites;
+            suites.swap(deferred);
+            std::stable_sort(suites.begin(), suites.end(), [this](const DeferredSuite& a, const DeferredSuite& b) {
+                return PriorityOf(a) < PriorityOf(b);
+            });
+            for (auto& suite : suites) { suite.registration(); }
+        }
+
+        bool StopRequested() const {
+            return !stopPath.empty() && std::ifstream(stopPath).good();
+        }
+
+        void Record(const std::string& test, const bool failed, const long long durationMs) {
+            results.push_back({test, failed, durationMs});
+            if (failed && !stopPath.empty()) {
+                std::ofstream(stopPath) << test << '\n';
+            }
+        }
+
+        /// Merges into the latest file so parallel workers don't drop each other's results
+        void Save() const {
+            if (historyPath.empty()) { return; }
+            TestHistory latest;
+            {
+                std::ifstream in(historyPath);
+                latest.Load(in);
+            }
+            // Usually the same run, unless a later one finished first
+            latest.run = std::max(history.run, latest.run - 1);
+            for (const auto& result : results) {
+                latest.Record(result.test, result.failed, result.durationMs);
+            }
+            const std::string temporary = historyPath + "." + std::to_string(CppUnit2Gtest_getpid_());
+            {
+                std::ofstream out(temporary);
+                latest.Save(out);
+                if (!out) { return; }
+            }
+            std::rename(temporary.c_str(), historyPath.c_str());
+        }
+    };
+
+    struct PrioritizationListener : ::testing::EmptyTestEventListener {
+        Prioritizer& prioritizer;
+        explicit PrioritizationListener(Prioritizer& prioritizer_) : prioritizer(prioritizer_) {}
+
+        void OnTestProgramStart(const ::testing::UnitTest&) override {
+            if (prioritizer.failFast) { ::testing::GTEST_FLAG(fail_fast) = true; }
+            if (!prioritizer.deferred.empty()) {
+                ADD_FAILURE() << prioritizer.deferred.size() << " CppUnit suites were not run, with CPPUNIT2GTEST_HISTORY_FILE set "
+                    "call CppUnit::to::gtest::RegisterPrioritizedTests() (or use TextTestRunner) before RUN_ALL_TESTS";
+            }
+        }
+
+        void OnTestEnd(const ::testing::TestInfo& info) override {
+            const auto* result = info.result();
+            if (result->Skipped()) { return; }
+            prioritizer.Record(std::string{info.test_suite_name()} + "." + info.name(), result->Failed(), static_cast<long long>(result->elapsed_time()));
+        }
+
+        void OnTestProgramEnd(const ::testing::UnitTest&) override { prioritizer.Save(); }
+    };
+
+    /// Set up from CPPUNIT2GTEST_HISTORY_FILE (reorder suites), CPPUNIT2GTEST_FAIL_FAST (stop at the first failure)
+    ///  and CPPUNIT2GTEST_STOP_FILE (created on failure, when it exists other workers skip their remaining tests), or nullptr
+    inline Prioritizer* EnvironmentPrioritizer_() {
+        static Prioritizer* prioritizer = []() -> Prioritizer* {
+            const char* historyPath = std::getenv("CPPUNIT2GTEST_HISTORY_FILE");
+            const char* failFast = std::getenv("CPPUNIT2GTEST_FAIL_FAST");
+            const char* stopPath = std::getenv("CPPUNIT2GTEST_STOP_FILE");
+            const bool isFailFast = failFast != nullptr && std::string{failFast} != "0" && std::string{failFast} != "";
+            if (historyPath == nullptr && !isFailFast && stopPath == nullptr) { return nullptr; }
+            // Deliberately leaked, the listener uses it until the end of the program
+            auto* created = new Prioritizer(historyPath != nullptr ? historyPath : "", stopPath != nullptr ? stopPath : "", isFailFast);
+            ::testing::UnitTest::GetInstance()->listeners().Append(new PrioritizationListener(*created));
+            return created;
+        }();
+        return prioritizer;
+    }
+
+    inline bool DeferRegistration_(const std::string& suite, std::vector<std::string> testNames, std::function<void()> registration) {
+        Prioritizer* prioritizer = EnvironmentPrioritizer_();
+        return prioritizer != nullptr && prioritizer->Defer({suite, std::move(testNames), std::move(registration)});
+    }
+
+    inline bool RunsBefore_(const std::string& suite, const char* a, const char* b) {
+        const Prioritizer* prioritizer = EnvironmentPrioritizer_();
+        return prioritizer != nullptr
+            && prioritizer->history.PriorityOf(suite + "." + a) < prioritizer->history.PriorityOf(suite + "." + b);
+    }
+
+    inline bool StopRequested_() {
+        const Prioritizer* prioritizer = EnvironmentPrioritizer_();
+        return prioritizer != nullptr && prioritizer->StopRequested();
+    }
+
+    /// Registers the CppUnit suites held back by CPPUNIT2GTEST_HISTORY_FILE, most urgent first.
+    ///  Custom mains must call this before RUN_ALL_TESTS (TextTestRunner does)
+    inline void RegisterPrioritizedTests() {
+        Prioritizer* prioritizer = EnvironmentPrioritizer_();
+        if (prioritizer != nullptr) { prioritizer->RegisterDeferred(); }
+    }
+
+    // So TestFactoryRegistry::makeTest lists the deferred suites
+    inline const bool prioritizationMainHook_ = []() {
+        MainHooks_::Instance().beforeListing.push_back(&RegisterPrioritizedTests);
+        return true;
+    }();
+#endif // CppUnit2Gtest_EnablePrioritization
+
+#if defined(CppUnit2Gtest_EnableDaemon) || defined(CppUnit2Gtest_EnableScheduling)
+    /// Starts running the tests matching the gtest filter in a forked child writing its output to outputFd,
+    ///  so every run starts from the state after registration. The child is pinned to cpus when given
+    inline pid_t StartFilterInChild_(const std::string& filter, const int outputFd, const std::vector<int>& cpus = {}) {
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        const pid_t child = fork();
+        if (child != 0) { return child; }
+        dup2(outputFd, STDOUT_FILENO);
+        dup2(outputFd, STDERR_FILENO);
+#   if defined(__linux__) && defined(CPU_SET)
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : cpus) { CPU_SET(cpu, &set); }
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+#   else
+        static_cast<void>(cpus);
+#   endif
+        ::testing::GTEST_FLAG(filter) = filter.empty() ? "*" : filter;
+        const int result = RUN_ALL_TESTS();
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        // Skip the parent's static destructors and exit handlers
+        _exit(result);
+    }
+
+    /// Exit code of a child, or 128 + the signal that killed it
+    inline int ExitCodeOf_(const int status) {
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
+
+    /// Runs StartFilterInChild_ to the end and returns the child's exit code
+    inline int RunFilterInChild_(const std::string& filter, const int outputFd) {
+        const pid_t child = StartFilterInChild_(filter, outputFd);
+        if (child < 0) { return -1; }
+        int status = 0;
+        while (waitpid(child, &status, 0) < 0) {
+            if (errno != EINTR) { return -1; }
+        }
+        return ExitCodeOf_(status);
+    }
+#endif
+
+#if defined(CppUnit2Gtest_EnableDaemon)
+
+    /// Last line of every daemon reply, followed by the exit code of the run
+    constexpr const char* daemonExitMarker = "CPPUNIT2GTEST_EXIT ";
+
+    inline std::string ReadLine_(const int fd) {
+        std::string line;
+        char c = 0;
+        while (line.size() < 65536 && read(fd, &c, 1) == 1 && c != '\n') { line += c; }
+        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+        return line;
+    }
+
+    inline void SendAll_(const int fd, const std::string& data) {
+#   if defined(MSG_NOSIGNAL)
+        const int flags = MSG_NOSIGNAL;
+#   else
+        const int flags = 0;
+#   endif
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const auto written = send(fd, data.data() + sent, data.size() - sent, flags);
+            if (written <= 0) { return; }
+            sent += static_cast<size_t>(written);
+        }
+    }
+
+    inline bool FillSocketAddress_(const std::string& socketPath, sockaddr_un& address) {
+        address = sockaddr_un{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Invalid unix socket path: " << socketPath << '\n';
+            return false;
+        }
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        return true;
+    }
+
+    using FilterRunner = std::function<int(const std::string& filter, int outputFd)>;
+
+    /// Keeps the registered tests resident and serves requests on a unix socket, one per connection:
+    ///  "run <gtest filter>" runs the matching tests in a forked child streaming its output back, "quit" stops.
+    ///  Every reply ends with a daemonExitMarker line
+    inline int ServeTests(const std::string& socketPath, const FilterRunner& runFilter = RunFilterInChild_) {
+        sockaddr_un address;
+        if (!FillSocketAddress_(socketPath, address)) { return 1; }
+        const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server < 0) {
+            std::cerr << "Cannot create a unix socket: " << std::strerror(errno) << '\n';
+            return 1;
+        }
+        unlink(socketPath.c_str());
+        if (bind(server, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(server, 16) != 0) {
+            std::cerr << "Cannot listen on " << socketPath << ": " << std::strerror(errno) << '\n';
+            close(server);
+            return 1;
+        }
+        std::cout << "[ DAEMON   ] Serving tests on " << socketPath << std::endl;
+        bool serving = true;
+        while (serving) {
+            const int client = accept(server, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR) { continue; }
+                break;
+            }
+            const std::string request = ReadLine_(client);
+            int result = 0;
+            if (request == "quit") {
+                serving = false;
+            } else if (request == "run" || request.compare(0, 4, "run ") == 0) {
+                result = runFilter(request.size() > 4 ? request.substr(4) : "", client);
+            } else {
+                SendAll_(client, "Unknown request \"" + request + "\", expected \"run <gtest filter>\" or \"quit\"\n");
+                result = 2;
+            }
+            SendAll_(client, daemonExitMarker + std::to_string(result) + "\n");
+            close(client);
+        }
+        close(server);
+        unlink(socketPath.c_str());
+        return 0;
+    }
+
+    /// Sends a request to ServeTests and copies the reply to out. Returns the exit code of the run or -1
+    inline int RequestTests(const std::string& socketPath, const std::string& request, std::ostream& out = std::cout) {
+        sockaddr_un address;
+        if (!FillSocketAddress_(socketPath, address)) { return -1; }
+        const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server < 0) { return -1; }
+        if (connect(server, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            std::cerr << "Cannot connect to " << socketPath << ": " << std::strerror(errno) << '\n';
+            close(server);
+            return -1;
+        }
+        SendAll_(server, request + "\n");
+        int result = -1;
+        std::string pending;
+        char buffer[4096];
+        for (auto received = read(server, buffer, sizeof(buffer)); received > 0; received = read(server, buffer, sizeof(buffer))) {
+            pending.append(buffer, static_cast<size_t>(received));
+            // Pass on whole lines as they come, apart from the exit marker
+            size_t start = 0;
+            for (size_t end = pending.find('\n'); end != std::string::npos; end = pending.find('\n', start)) {
+                const std::string line = pending.substr(start, end - start);
+                // The output of the run might not end with a new line
+                const auto marker = line.find(daemonExitMarker);
+                if (marker == std::string::npos) {
+                    out << line << '\n';
+                } else {
+                    out << line.substr(0, marker);
+                    result = std::atoi(line.c_str() + marker + std::strlen(daemonExitMarker));
+                }
+                start = end + 1;
+            }
+            pending.erase(0, start);
+            out.flush();
+        }
+        out << pending;
+        close(server);
+        return result;
+    }
+
+    // TextTestRunner::run serves the tests when CPPUNIT2GTEST_DAEMON_SOCKET is set
+    inline const bool daemonMainHook_ = []() {
+        MainHooks_::Instance().runners.push_back([](bool& passed) {
+            const char* socketPath = std::getenv("CPPUNIT2GTEST_DAEMON_SOCKET");
+            if (socketPath == nullptr) { return false; }
+            passed = 0 == ServeTests(socketPath);
+            return true;
+        });
+        return true;
+    }();
+#endif // CppUnit2Gtest_EnableDaemon
+
+#if defined(CppUnit2Gtest_EnableScheduling) || defined(CppUnit2Gtest_EnableSamplingProfiler)
+    /// Matches gtest's filter syntax, "positive:patterns-negative:patterns" with * and ? wildcards
+    inline bool MatchesFilter_(const std::string& filter, const std::string& name) {
+        const auto glob = [](const std::string& pattern, const std::string& text) {
+            size_t p = 0, t = 0, star = std::string::npos, mark = 0;
+            while (t < text.size()) {
+                if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) { ++p; ++t; }
+                else if (p < pattern.size() && pattern[p] == '*') { star = p++; mark = t; }
+                else if (star != std::string::npos) { p = star + 1; t = ++mark; }
+                else { return false; }
+            }
+            while (p < pattern.size() && pattern[p] == '*') { ++p; }
+            return p == pattern.size();
+        };
+        const auto anyMatches = [&glob, &name](const std::string& patterns) {
+            size_t start = 0;
+            while (true) {
+                const size_t end = patterns.find(':', start);
+                if (glob(patterns.substr(start, end - start), name)) { return true; }
+                if (end == std::string::npos) { return false; }
+                start = end + 1;
+            }
+        };
+        const size_t dash = filter.find('-');
+        const std::string positive = filter.substr(0, dash);
+        const bool included = positive.empty() || anyMatches(positive);
+        return included && (dash == std::string::npos || !anyMatches(filter.substr(dash + 1)));
+    }
+#endif
+
+#if defined(CppUnit2Gtest_EnableScheduling)
+    inline std::map<std::string, Properties>& SchedulingProperties_() {
+        static std::map<std::string, Properties> properties;
+        return properties;
+    }
+
+    inline void RecordSchedulingProperties_(const std::string& suite, const std::string& test, const Properties& properties) {
+        SchedulingProperties_()[suite + "." + test] = properties;
+    }
+
+    /// True for flags such as CPPUNIT_TEST_SUITE_PROPERTY("slow", "true"), anything but "0" and "false" counts
+    inline bool HasFlag_(const Properties& properties, const std::string& key) {
+        const std::string* value = FindProperty(properties, key);
+        return value != nullptr && *value != "0" && *value != "false";
+    }
+
+    /// Tests run together in one worker: the tests of a suite, or a single test with the parallel_safe property.
+    ///  Demands come from the cpus, memory_mb, exclusive and slow properties
+    struct ScheduledUnit {
+        std::string name;
+        std::string filter;
+        unsigned cpus = 1;
+        unsigned long long memoryMb = 0;
+        bool exclusive = false;
+        bool slow = false;
+
+        void Add(const std::string& test, const Properties& properties) {
+            filter += (filter.empty() ? "" : ":") + test;
+            const std::string* cpusProperty = FindProperty(properties, "cpus");
+            const std::string* memoryProperty = FindProperty(properties, "memory_mb");
+            if (cpusProperty != nullptr) { cpus = std::max(cpus, static_cast<unsigned>(std::strtoul(cpusProperty->c_str(), nullptr, 10))); }
+            if (memoryProperty != nullptr) { memoryMb = std::max(memoryMb, std::strtoull(memoryProperty->c_str(), nullptr, 10)); }
+            exclusive = exclusive || HasFlag_(properties, "exclusive");
+            slow = slow || HasFlag_(properties, "slow");
+        }
+    };
+
+    /// Units for the registered tests matching the filter, in the order they should start:
+    ///  exclusive first, then slow, then the largest so the small ones fill the gaps
+    inline std::vector<ScheduledUnit> PlanUnits_(const std::string& filter, const bool includeDisabled) {
+        std::vector<ScheduledUnit> units;
+        const auto* unitTest = ::testing::UnitTest::GetInstance();
+        const auto& allProperties = SchedulingProperties_();
+        const std::string disabled = "DISABLED_";
+        for (int i = 0; i < unitTest->total_test_suite_count(); ++i) {
+            const auto* testSuite = unitTest->GetTestSuite(i);
+            const std::string suiteName = testSuite->name();
+            ScheduledUnit suite;
+            suite.name = suiteName;
+            for (int j = 0; j < testSuite->total_test_count(); ++j) {
+                const std::string testName = testSuite->GetTestInfo(j)->name();
+                const std::string fullName = suiteName + "." + testName;
+                const bool isDisabled = suiteName.compare(0, disabled.size(), disabled) == 0 || testName.compare(0, disabled.size(), disabled) == 0;
+                if ((isDisabled && !includeDisabled) || !MatchesFilter_(filter, fullName)) { continue; }
+                const auto found = allProperties.find(fullName);
+                const Properties none;
+                const Properties& properties = found != allProperties.end() ? found->second : none;
+                if (HasFlag_(properties, "parallel_safe")) {
+                    ScheduledUnit single;
+                    single.name = fullName;
+                    single.Add(fullName, properties);
+                    units.push_back(single);
+                } else {
+                    suite.Add(fullName, properties);
+                }
+            }
+            if (!suite.filter.empty()) { units.push_back(suite); }
+        }
+        std::stable_sort(units.begin(), units.end(), [](const ScheduledUnit& a, const ScheduledUnit& b) {
+            return std::make_tuple(!a.exclusive, !a.slow, b.memoryMb, b.cpus) < std::make_tuple(!b.exclusive, !b.slow, a.memoryMb, a.cpus);
+        });
+        return units;
+    }
+
+    /// Cores and memory used by the running workers. Demands above the machine's are capped, so they run alone
+    struct ResourcePool {
+        struct Allocation {
+            std::vector<int> cpuIds;
+            unsigned long long memoryMb;
+            bool exclusive;
+        };
+        std::vector<int> cpuIds;
+        std::vector<bool> cpuTaken;
+        unsigned long long memoryMb;
+        unsigned long long usedMemoryMb = 0;
+        size_t running = 0;
+        bool exclusiveRunning = false;
+
+        /// Zero memoryMb doesn't limit memory
+        ResourcePool(std::vector<int> cpuIds_, const unsigned long long memoryMb_)
+            : cpuIds(cpuIds_.empty() ? std::vector<int>{0} : std::move(cpuIds_)), cpuTaken(cpuIds.size(), false), memoryMb(memoryMb_) {}
+
+        size_t FreeCpus() const { return static_cast<size_t>(std::count(cpuTaken.begin(), cpuTaken.end(), false)); }
+        size_t CpusOf(const ScheduledUnit& unit) const { return unit.exclusive ? cpuIds.size() : std::min<size_t>(std::max(unit.cpus, 1u), cpuIds.size()); }
+        unsigned long long MemoryOf(const ScheduledUnit& unit) const { return unit.exclusive ? memoryMb : std::min(unit.memoryMb, memoryMb); }
+
+        bool CanStart(const ScheduledUnit& unit) const {
+            if (exclusiveRunning || (unit.exclusive && running > 0)) { return false; }
+            return CpusOf(unit) <= FreeCpus() && usedMemoryMb + MemoryOf(unit) <= memoryMb;
+        }
+
+        Allocation Start(const ScheduledUnit& unit) {
+            Allocation allocation{{}, MemoryOf(unit), unit.exclusive};
+            const size_t cpus = CpusOf(unit);
+            for (size_t i = 0; i < cpuTaken.size() && allocation.cpuIds.size() < cpus; ++i) {
+                if (!cpuTaken[i]) {
+                    cpuTaken[i] = true;
+                    allocation.cpuIds.push_back(cpuIds[i]);
+                }
+            }
+            usedMemoryMb += allocation.memoryMb;
+            exclusiveRunning = unit.exclusive;
+            ++running;
+            return allocation;
+        }
+
+        void Finish(const Allocation& allocation) {
+            for (const int cpu : allocation.cpuIds) {
+                cpuTaken[static_cast<size_t>(std::find(cpuIds.begin(), cpuIds.end(), cpu) - cpuIds.begin())] = false;
+            }
+            usedMemoryMb -= allocation.memoryMb;
+            exclusiveRunning = exclusiveRunning && !allocation.exclusive;
+            --running;
+        }
+    };
+
+    /// Cpus this process may use: CPPUNIT2GTEST_JOBS of them if set
+    inline std::vector<int> AvailableCpus_() {
+        std::vector<int> cpus;
+#   if defined(__linux__) && defined(CPU_SET)
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+            }
+        }
+#   endif
+        if (cpus.empty()) {
+            for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); ++cpu) { cpus.push_back(static_cast<int>(cpu)); }
+        }
+        const char* jobs = std::getenv("CPPUNIT2GTEST_JOBS");
+        if (jobs != nullptr && std::atoi(jobs) > 0) { cpus.resize(std::min(cpus.size(), static_cast<size_t>(std::atoi(jobs)))); }
+        return cpus;
+    }
+
+    /// Memory for the tests in MB, CPPUNIT2GTEST_MEMORY_MB or all of the machine's
+    inline unsigned long long AvailableMemoryMb_() {
+        const char* memory = std::getenv("CPPUNIT2GTEST_MEMORY_MB");
+        if (memory != nullptr) { return std::strtoull(memory, nullptr, 10); }
+        const long pages = sysconf(_SC_PHYS_PAGES);
+        const long pageSize = sysconf(_SC_PAGE_SIZE);
+        return pages > 0 && pageSize > 0 ? static_cast<unsigned long long>(pages) * static_cast<unsigned long long>(pageSize) / (1024 * 1024) : 0;
+    }
+
+    /// Runs the registered tests (matching --gtest_filter) in forked workers packed onto the machine by
+    ///  their scheduling properties, pinned to their cpus with CPPUNIT2GTEST_PIN_CPUS=1. Returns true if all passed
+    inline bool RunScheduledTests() {
+        struct Worker {
+            ScheduledUnit unit;
+            ResourcePool::Allocation allocation;
+            std::FILE* output;
+        };
+        auto pending = PlanUnits_(::testing::GTEST_FLAG(filter), ::testing::GTEST_FLAG(also_run_disabled_tests));
+        ResourcePool pool(AvailableCpus_(), AvailableMemoryMb_());
+        const char* pin = std::getenv("CPPUNIT2GTEST_PIN_CPUS");
+        const bool pinned = pin != nullptr && std::string{pin} != "0";
+        std::cout << "[ SCHEDULE ] " << pending.size() << " units on " << pool.cpuIds.size() << " cpus\n" << std::flush;
+        std::map<pid_t, Worker> workers;
+        std::vector<std::string> failed;
+        while (!pending.empty() || !workers.empty()) {
+            for (auto unit = pending.begin(); unit != pending.end();) {
+                if (!pool.CanStart(*unit)) {
+                    // Nothing overtakes a waiting exclusive unit, or it could wait forever
+                    if (unit->exclusive) { break; }
+                    ++unit;
+                    continue;
+                }
+                const auto allocation = pool.Start(*unit);
+                std::FILE* output = std::tmpfile();
+                const pid_t child = output == nullptr ? -1 : StartFilterInChild_(unit->filter, fileno(output), pinned ? allocation.cpuIds : std::vector<int>{});
+                if (child < 0) {
+                    failed.push_back(unit->name + " (cannot start a worker)");
+                    pool.Finish(allocation);
+                    if (output != nullptr) { std::fclose(output); }
+                } else {
+                    workers[child] = Worker{*unit, allocation, output};
+                }
+                unit = pending.erase(unit);
+            }
+            if (workers.empty()) { continue; }
+            int status = 0;
+            const pid_t child = waitpid(-1, &status, 0);
+            if (child < 0 && errno == EINTR) { continue; }
+            if (child < 0) { break; }
+            const auto worker = workers.find(child);
+            if (worker == workers.end()) { continue; }
+            // Whole outputs so workers don't interleave
+            std::rewind(worker->second.output);
+            char buffer[4096];
+            for (size_t count = std::fread(buffer, 1, sizeof(buffer), worker->second.output); count > 0; count = std::fread(buffer, 1, sizeof(buffer), worker->second.output)) {
+                std::cout.write(buffer, static_cast<std::streamsize>(count));
+            }
+            std::cout.flush();
+            std::fclose(worker->second.output);
+            if (ExitCodeOf_(status) != 0) { failed.push_back(worker->second.unit.name); }
+            pool.Finish(worker->second.allocation);
+            workers.erase(worker);
+        }
+        std::cout << "[ SCHEDULE ] " << failed.size() << " units failed\n";
+        for (const auto& name : failed) { std::cout << "[  FAILED  ] " << name << '\n'; }
+        std::cout << std::flush;
+        return failed.empty();
+    }
+
+    // TextTestRunner::run schedules the tests when CPPUNIT2GTEST_SCHEDULE is set
+    inline const bool schedulingMainHook_ = []() {
+        MainHooks_::Instance().runners.push_back([](bool& passed) {
+            const char* schedule = std::getenv("CPPUNIT2GTEST_SCHEDULE");
+            if (schedule == nullptr || std::string{schedule} == "0") { return false; }
+            passed = RunScheduledTests();
+            return true;
+        });
+        return true;
+    }();
+#endif // CppUnit2Gtest_EnableScheduling
+
+#if defined(CppUnit2Gtest_EnableForkIsolation)
+    /// True if the test runs in a forked child, from its "isolation" property or CPPUNIT2GTEST_ISOLATION ("fork")
+    inline bool IsForkIsolated_(const Properties& properties) {
+        const std::string* isolation = FindProperty(properties, "isolation");
+        if (isolation != nullptr) { return *isolation == "fork"; }
+        const char* environment = std::getenv("CPPUNIT2GTEST_ISOLATION");
+        return environment != nullptr && std::string{environment} == "fork";
+    }
+
+    /// Deadline of a forked test from the "timeout_ms" property or CPPUNIT2GTEST_TIMEOUT_MS, 0 for none
+    inline long long ForkTimeoutMs_(const Properties& properties) {
+        const std::string* property = FindProperty(properties, "timeout_ms");
+        if (property != nullptr) { return std::atoll(property->c_str()); }
+        const char* environment = std::getenv("CPPUNIT2GTEST_TIMEOUT_MS");
+        if (environment != nullptr) { return std::atoll(environment); }
+#   if defined(CppUnit2Gtest_EnableTimeouts)
+        return static_cast<long long>(DefaultTimeout_().count());
+#   else
+        return 0;
+#   endif
+    }
+
+    /// Type of the records that carry a property recorded in the child, the key and value take the file and message
+    constexpr int ForkedPropertyRecord_ = -1;
+
+    /// Results go from the child as "<type> <line> <file size> <message size>\n<file><message>" then "end\n"
+    inline std::string SerializeTestPartResults_(const ::testing::TestPartResultArray& results, const Properties& properties = {}) {
+        std::ostringstream out;
+        for (const auto& property : properties) {
+            out << ForkedPropertyRecord_ << " 0 " << property.first.size() << ' ' << property.second.size() << '\n'
+                << property.first << property.second;
+        }
+        for (int i = 0; i < results.size(); ++i) {
+            const auto& result = results.GetTestPartResult(i);
+            const std::string file = result.file_name() != nullptr ? result.file_name() : "";
+            const std::string message = result.message() != nullptr ? result.message() : "";
+            out << static_cast<int>(result.type()) << ' ' << result.line_number() << ' '
+                << file.size() << ' ' << message.size() << '\n' << file << message;
+        }
+        out << "end\n";
+        return out.str();
+    }
+
+    /// Reports the child's results and records its properties in the running test,
+    ///  returns false if the child didn't finish writing them
+    inline bool ReportTestPartResults_(const std::string& data) {
+        std::istringstream in(data);
+        int type = 0;
+        int line = 0;
+        size_t fileSize = 0;
+        size_t messageSize = 0;
+        while (in >> type >> line >> fileSize >> messageSize && in.get() == '\n') {
+            std::string file(fileSize, '\0');
+            std::string message(messageSize, '\0');
+            if (!in.read(&file[0], static_cast<std::streamsize>(fileSize)) || !in.read(&message[0], static_cast<std::streamsize>(messageSize))) { return false; }
+            if (type == ForkedPropertyRecord_) {
+                ::testing::Test::RecordProperty(file, message);
+                continue;
+            }
+            const auto resultType = static_cast<::testing::TestPartResult::Type>(type);
+            if (resultType == ::testing::TestPartResult::kSuccess) { continue; }
+            ::testing::internal::AssertHelper(resultType, file.empty() ? nullptr : file.c_str(), line, message.c_str()) = ::testing::Message();
+        }
+        in.clear();
+        std::string end;
+        return static_cast<bool>(in >> end) && end == "end";
+    }
+
+    inline bool StopsTest_(const ::testing::TestPartResultArray& results) {
+        for (int i = 0; i < results.size(); ++i) {
+            if (results.GetTestPartResult(i).fatally_failed() || results.GetTestPartResult(i).skipped()) { return true; }
+        }
+        return false;
+    }
+
+    /// Runs a stage in the child, reporting exceptions like gtest does
+    inline void RunForkedStage_(const std::function<void()>& stage, const char* where) {
+        try {
+            stage();
+        } catch (const std::exception& e) {
+            ADD_FAILURE() << "C++ exception with description \"" << e.what() << "\" thrown in " << where << ".";
+        } catch (...) {
+            ADD_FAILURE() << "Unknown C++ exception thrown in " << where << ".";
+        }
+    }
+
+    /// Forks, runs the stages (as gtest would) in the child and reports its results in the current test.
+    ///  The child is killed after timeoutMs (when above 0)
+    inline void RunInForkedChild_(
+        const std::function<void()>& setUp,
+        const std::function<void()>& body,
+        const std::function<void()>& tearDown,
+        const long long timeoutMs)
+    {
+        int channel[2];
+        if (pipe(channel) != 0) {
+            ADD_FAILURE() << "Cannot create a pipe for a forked test: " << std::strerror(errno);
+            return;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        const pid_t child = fork();
+        if (child < 0) {
+            ADD_FAILURE() << "Cannot fork a test: " << std::strerror(errno);
+            close(channel[0]);
+            close(channel[1]);
+            return;
+        }
+        if (child == 0) {
+            close(channel[0]);
+            ::testing::TestPartResultArray results;
+            {
+                // Other threads report to the global reporter, this one to its own (which might have been replaced)
+                ::testing::ScopedFakeTestPartResultReporter allThreads(
+                    ::testing::ScopedFakeTestPartResultReporter::INTERCEPT_ALL_THREADS, &results);
+                ::testing::ScopedFakeTestPartResultReporter thisThread(
+                    ::testing::ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD, &results);
+                RunForkedStage_(setUp, "SetUp()");
+                if (!StopsTest_(results)) { RunForkedStage_(body, "the test body"); }
+                RunForkedStage_(tearDown, "TearDown()");
+            }
+#if defined(CppUnit2Gtest_EnableTracing)
+            FlushTrace_();
+#endif
+            // The child's properties (i.e. from RecordProperty in the test) are recorded again by the parent
+            Properties properties;
+            const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+            for (int i = 0; info != nullptr && i < info->result()->test_property_count(); ++i) {
+                const auto& property = info->result()->GetTestProperty(i);
+                properties.emplace_back(property.key(), property.value());
+            }
+            const std::string data = SerializeTestPartResults_(results, properties);
+            for (size_t written = 0; written < data.size(); ) {
+                const auto count = write(channel[1], data.data() + written, data.size() - written);
+                if (count <= 0) { break; }
+                written += static_cast<size_t>(count);
+            }
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+            // Skip the parent's static destructors and exit handlers
+            _exit(0);
+        }
+        close(channel[1]);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        std::string data;
+        bool timedOut = false;
+        char buffer[4096];
+        while (true) {
+            int wait = -1;
+            if (timeoutMs > 0) {
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (remaining <= 0) { timedOut = true; break; }
+                wait = static_cast<int>(remaining);
+            }
+            pollfd readable{channel[0], POLLIN, 0};
+            const int ready = poll(&readable, 1, wait);
+            if (ready < 0 && errno == EINTR) { continue; }
+            if (ready < 0) { break; }
+            if (ready == 0) { continue; }
+            const auto count = read(channel[0], buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) { continue; }
+            if (count <= 0) { break; }
+            data.append(buffer, static_cast<size_t>(count));
+        }
+        close(channel[0]);
+        if (timedOut) { kill(child, SIGKILL); }
+        int status = 0;
+        while (waitpid(child, &status, 0) < 0 && errno == EINTR) {}
+        const bool finished = ReportTestPartResults_(data);
+        if (timedOut) {
+            ADD_FAILURE() << "Forked test timed out after " << timeoutMs << " ms and was killed";
+        } else if (WIFSIGNALED(status)) {
+            ADD_FAILURE() << "Forked test was killed by signal " << WTERMSIG(status);
+        } else if (!finished) {
+            ADD_FAILURE() << "Forked test exited with code " << WEXITSTATUS(status) << " before it finished";
+        }
+    }
+
+    /// With fork isolation the fixture is constructed in the parent (after SetUpTestSuite),
+    ///  then setUp, the test and tearDown run in a copy-on-write child so tests can't change the suite's state
+    template<typename TestSuite>
+    struct ManagedTest : DynamicTest<TestSuite> {
+        using Base = DynamicTest<TestSuite>;
+        bool isolated = false;
+
+        explicit ManagedTest(const TestData<TestSuite>& testData_)
+            : Base(testData_), isolated(IsForkIsolated_(testData_.properties))
+        {
+#   if defined(CppUnit2Gtest_EnableTimeouts)
+            // The child is killed on its deadline instead of the watchdog stopping everything
+            if (isolated) { DisarmWatchdog_(); }
+#   endif
+        }
+
+        void SetUp() override { if (!isolated) { Base::SetUp(); } }
+        void TearDown() override { if (!isolated) { Base::TearDown(); } }
+
+        void TestBody() override {
+            if (!isolated) {
+                Base::TestBody();
+                return;
+            }
+            this->RecordTestProperties();
+#   if defined(CppUnit2Gtest_EnableRetries)
+            // Every attempt is a new child of the untouched fixture
+            const int retries = Retries_(this->testData->properties);
+            if (retries > 0) {
+                const auto attempt = [this](::testing::TestPartResultArray& results) {
+                    RunAttemptStage_(results, [this]() { RunForked(); }, "the forked test");
+                };
+                this->RunAttempts(retries, attempt, attempt);
+                return;
+            }
+#   endif
+            RunForked();
+        }
+
+        void RunForked() {
+            RunInForkedChild_(
+                [this]() { Base::SetUp(); },
+                [this]() { this->RunTestMethod(); },
+                [this]() { Base::TearDown(); },
+                ForkTimeoutMs_(this->testData->properties));
+        }
+    };
+#endif // CppUnit2Gtest_EnableForkIsolation
+
+#if defined(CppUnit2Gtest_EnableBenchmarks) || defined(CppUnit2Gtest_EnablePerformanceAssertions)
+    /// Summary of a set of samples, all in the unit of the samples
+    struct SampleStatistics {
+        size_t count = 0;
+        double mean = 0;
+        double median = 0;
+        /// 95% confidence interval of the median, from the order statistics
+        double medianLow = 0;
+        double medianHigh = 0;
+        double p99 = 0;
+        double min = 0;
+        double max = 0;
+        double stddev = 0;
+
+        /// Relative spread of the samples, stddev / mean
+        [[nodiscard]] double Variation() const { return mean > 0 ? stddev / mean : 0; }
+
+        [[nodiscard]] static SampleStatistics Of(std::vector<double> samples) {
+            SampleStatistics statistics;
+            statistics.count = samples.size();
+            if (samples.empty()) { return statistics; }
+            std::sort(samples.begin(), samples.end());
+            // Nearest rank percentiles, the median of an even count is the mean of the middle two
+            const size_t middle = samples.size() / 2;
+            statistics.median = samples.size() % 2 == 0 ? (samples[middle - 1] + samples[middle]) / 2 : samples[middle];
+            const auto rank = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(samples.size())));
+            statistics.p99 = samples[std::max<size_t>(rank, 1) - 1];
+            const double n = static_cast<double>(samples.size());
+            const double halfWidth = 1.96 * std::sqrt(n) / 2;
+            const auto lowRank = static_cast<size_t>(std::max(1.0, std::round(n / 2 - halfWidth)));
+            const auto highRank = static_cast<size_t>(std::min(n, std::round(1 + n / 2 + halfWidth)));
+            statistics.medianLow = samples[lowRank - 1];
+            statistics.medianHigh = samples[highRank - 1];
+            statistics.min = samples.front();
+            statistics.max = samples.back();
+            double sum = 0;
+            for (const double sample : samples) { sum += sample; }
+            statistics.mean = sum / static_cast<double>(samples.size());
+            double squares = 0;
+            for (const double sample : samples) { squares += (sample - statistics.mean) * (sample - statistics.mean); }
+            statistics.stddev = samples.size() > 1 ? std::sqrt(squares / static_cast<double>(samples.size() - 1)) : 0;
+            return statistics;
+        }
+    };
+#endif // CppUnit2Gtest_EnableBenchmarks || CppUnit2Gtest_EnablePerformanceAssertions
+
+#if defined(CppUnit2Gtest_EnableBenchmarks)
+    /// Sample count and time budget, from CPPUNIT2GTEST_BENCHMARK_SAMPLES, _MIN_TIME_MS and _WARMUP_MS
+    struct BenchmarkSettings {
+        unsigned samples = 30;
+        std::chrono::nanoseconds minTime = std::chrono::milliseconds(500);
+        std::chrono::nanoseconds warmup = std::chrono::milliseconds(100);
+
+        [[nodiscard]] static BenchmarkSettings FromEnvironment() {
+            BenchmarkSettings settings;
+            const auto read = [](const char* name, const unsigned long fallback) {
+                const char* value = std::getenv(name);
+                const unsigned long parsed = value != nullptr ? std::strtoul(value, nullptr, 10) : 0;
+                return parsed > 0 ? parsed : fallback;
+            };
+            settings.samples = static_cast<unsigned>(read("CPPUNIT2GTEST_BENCHMARK_SAMPLES", settings.samples));
+            settings.minTime = std::chrono::milliseconds(read("CPPUNIT2GTEST_BENCHMARK_MIN_TIME_MS", 500));
+            settings.warmup = std::chrono::milliseconds(read("CPPUNIT2GTEST_BENCHMARK_WARMUP_MS", 100));
+            return settings;
+        }
+    };
+
+    /// Per iteration times of one benchmark, in nanoseconds
+    struct BenchmarkResult {
+        std::string name;
+        unsigned long long iterationsPerSample = 0;
+        SampleStatistics nanoseconds;
+
+        [[nodiscard]] double IterationsPerSecond() const { return nanoseconds.mean > 0 ? 1e9 / nanoseconds.mean : 0; }
+
+        [[nodiscard]] std::string ToJson() const {
+            std::ostringstream json;
+            json << "{\"name\":\"" << name << "\",\"samples\":" << nanoseconds.count
+                 << ",\"iterations_per_sample\":" << iterationsPerSample
+                 << ",\"mean_ns\":" << nanoseconds.mean << ",\"median_ns\":" << nanoseconds.median
+                 << ",\"median_low_ns\":" << nanoseconds.medianLow << ",\"median_high_ns\":" << nanoseconds.medianHigh
+                 << ",\"p99_ns\":" << nanoseconds.p99 << ",\"min_ns\":" << nanoseconds.min
+                 << ",\"max_ns\":" << nanoseconds.max << ",\"stddev_ns\":" << nanoseconds.stddev
+                 << ",\"cv\":" << nanoseconds.Variation()
+                 << ",\"iterations_per_second\":" << IterationsPerSecond() << "}";
+            return json.str();
+        }
+    };
+
+    /// Records the result on the running test (gtest's xml/json output), prints it and appends it
+    ///  as a json line to CPPUNIT2GTEST_BENCHMARK_OUTPUT when set
+    inline void ReportBenchmark_(const BenchmarkResult& result) {
+        const auto& s = result.nanoseconds;
+        ::testing::Test::RecordProperty("benchmark_samples", std::to_string(s.count));
+        ::testing::Test::RecordProperty("benchmark_iterations_per_sample", std::to_string(result.iterationsPerSample));
+        ::testing::Test::RecordProperty("benchmark_mean_ns", std::to_string(s.mean));
+        ::testing::Test::RecordProperty("benchmark_median_ns", std::to_string(s.median));
+        ::testing::Test::RecordProperty("benchmark_p99_ns", std::to_string(s.p99));
+        ::testing::Test::RecordProperty("benchmark_stddev_ns", std::to_string(s.stddev));
+        ::testing::Test::RecordProperty("benchmark_iterations_per_second", std::to_string(result.IterationsPerSecond()));
+        std::printf("[ BENCHMARK] %s mean %.1f ns, median %.1f ns, p99 %.1f ns, cv %.1f%%, %.0f/s (%zu x %llu)\n",
+            result.name.c_str(), s.mean, s.median, s.p99, 100 * s.Variation(), result.IterationsPerSecond(),
+            s.count, result.iterationsPerSample);
+        std::fflush(stdout);
+        if (const char* path = std::getenv("CPPUNIT2GTEST_BENCHMARK_OUTPUT")) {
+            std::ofstream output(path, std::ios::app);
+            output << result.ToJson() << '\n';
+        }
+    }
+
+    /// Runs the test method as a benchmark: warms up while doubling the iterations until a batch takes
+    ///  its share of the minimum time, then times that many iterations per sample.
+    ///  reset (tearDown then setUp) runs untimed after the warmup and between samples
+    template<typename Method, typename Reset>
+    BenchmarkResult RunBenchmark_(const Method& method, const Reset& reset, const BenchmarkSettings& settings = BenchmarkSettings::FromEnvironment()) {
+        using Clock = std::chrono::steady_clock;
+        const auto timeBatch = [&method](const unsigned long long iterations) {
+            const auto start = Clock::now();
+            for (unsigned long long i = 0; i < iterations; ++i) { method(); }
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        };
+        const double sampleTarget = static_cast<double>(settings.minTime.count()) / std::max(settings.samples, 1u);
+        const auto warmupEnd = Clock::now() + settings.warmup;
+        unsigned long long iterations = 1;
+        double elapsed = timeBatch(iterations);
+        while (!::testing::Test::HasFailure() && (elapsed < sampleTarget || Clock::now() < warmupEnd)) {
+            if (elapsed < sampleTarget) { iterations *= 2; }
+            elapsed = timeBatch(iterations);
+        }
+
+        const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+        BenchmarkResult result;
+        result.name = testInfo != nullptr ? std::string(testInfo->test_suite_name()) + "." + testInfo->name() : "";
+        result.iterationsPerSample = iterations;
+        std::vector<double> samples;
+        for (unsigned i = 0; i < settings.samples && !::testing::Test::HasFailure(); ++i) {
+            reset();
+            samples.push_back(timeBatch(iterations) / static_cast<double>(iterations));
+        }
+        if (::testing::Test::HasFailure()) { return result; }
+        result.nanoseconds = SampleStatistics::Of(std::move(samples));
+        ReportBenchmark_(result);
+        return result;
+    }
+#endif // CppUnit2Gtest_EnableBenchmarks
+
+#if defined(CppUnit2Gtest_EnablePerformanceAssertions)
+/// Samples taken by CPPUNIT_ASSERT_FASTER_THAN
+#   ifndef CppUnit2Gtest_PerformanceSamples
+#       define CppUnit2Gtest_PerformanceSamples 25
+#   endif
+/// Each sample repeats the expression until it takes at least this long
+#   ifndef CppUnit2Gtest_PerformanceSampleNs
+#       define CppUnit2Gtest_PerformanceSampleNs 1000000
+#   endif
+/// Runs of the expression counted by CPPUNIT_ASSERT_ALLOCATES_AT_MOST
+#   ifndef CppUnit2Gtest_AllocationRuns
+#       define CppUnit2Gtest_AllocationRuns 5
+#   endif
+
+    /// Nanoseconds per run of the expression, one sample per batch of runs
+    template<typename Expression>
+    SampleStatistics MeasureNanoseconds_(const Expression& expression, const unsigned samples = CppUnit2Gtest_PerformanceSamples) {
+        using Clock = std::chrono::steady_clock;
+        const auto timeBatch = [&expression](const unsigned long long iterations) {
+            const auto start = Clock::now();
+            for (unsigned long long i = 0; i < iterations; ++i) { expression(); }
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        };
+        unsigned long long iterations = 1;
+        while (timeBatch(iterations) < CppUnit2Gtest_PerformanceSampleNs && iterations < (1ull << 40)) { iterations *= 2; }
+        std::vector<double> nanoseconds;
+        for (unsigned i = 0; i < samples; ++i) {
+            nanoseconds.push_back(timeBatch(iterations) / static_cast<double>(iterations));
+        }
+        return SampleStatistics::Of(std::move(nanoseconds));
+    }
+
+    /// Allocations per run of the expression, one sample per run
+    template<typename Expression>
+    SampleStatistics MeasureAllocations_(const Expression& expression, const unsigned runs = CppUnit2Gtest_AllocationRuns) {
+        std::vector<double> allocations;
+        for (unsigned i = 0; i < runs; ++i) {
+            const unsigned long long before = AllocationCount_();
+            expression();
+            allocations.push_back(static_cast<double>(AllocationCount_() - before));
+        }
+        return SampleStatistics::Of(std::move(allocations));
+    }
+
+    /// Fails only when the whole confidence interval of the median is over budget, so noise alone does not fail
+    inline ::testing::AssertionResult WithinTimeBudget_(const double budgetNs, const char* expression, const SampleStatistics& nanoseconds) {
+        if (nanoseconds.medianLow <= budgetNs) { return ::testing::AssertionSuccess(); }
+        return ::testing::AssertionFailure()
+            << expression << " is slower than its budget of " << budgetNs << " ns\n"
+            << "  median " << nanoseconds.median << " ns (95% confidence " << nanoseconds.medianLow << " to " << nanoseconds.medianHigh << " ns)\n"
+            << "  mean " << nanoseconds.mean << " ns, p99 " << nanoseconds.p99 << " ns, min " << nanoseconds.min
+            << " ns over " << nanoseconds.count << " samples";
+    }
+
+    inline ::testing::AssertionResult WithinAllocationBudget_(const double budget, const char* expression, const SampleStatistics& allocations) {
+        if (!AllocationCounterInstalled_()) {
+            return ::testing::AssertionFailure()
+                << "Allocations are not counted, define CppUnit2Gtest_CountAllocations in one translation unit before including CppUnit2Gtest";
+        }
+        if (allocations.median <= budget) { return ::testing::AssertionSuccess(); }
+        return ::testing::AssertionFailure()
+            << expression << " allocates more than " << budget << " times\n"
+            << "  median " << allocations.median << " allocations (min " << allocations.min << ", max " << allocations.max
+            << ") over " << allocations.count << " runs";
+    }
+
+    /// Predicate formatters for the wrapper's PRED_FORMAT3, the expression is passed as text and as a lambda
+    template<typename Budget, typename Expression>
+    ::testing::AssertionResult FasterThan_(const char*, const char*, const char*, const Budget budgetNs, const char* expression, const Expression& run) {
+        return WithinTimeBudget_(static_cast<double>(budgetNs), expression, MeasureNanoseconds_(run));
+    }
+
+    template<typename Budget, typename Expression>
+    ::testing::AssertionResult AllocatesAtMost_(const char*, const char*, const char*, const Budget budget, const char* expression, const Expression& run) {
+        return WithinAllocationBudget_(static_cast<double>(budget), expression, MeasureAllocations_(run));
+    }
+#endif // CppUnit2Gtest_EnablePerformanceAssertions
+
+#if defined(CppUnit2Gtest_EnablePerfCounters)
+    /// Event counts of a test, or the sum over several tests
+    struct PerfCounts {
+        enum Counter : size_t { cycles, instructions, l1dMisses, llcMisses, branchMisses, contextSwitches, count };
+        std::array<unsigned long long, count> values{};
+        /// Counters that were measured, the others are left out of properties and tables
+        std::array<bool, count> measured{};
+
+        static const char* Name(const size_t counter) {
+            static const char* const names[count] = {
+                "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "context_switches"};
+            return names[counter];
+        }
+
+        /// Instructions per cycle, 0 when either wasn't measured
+        [[nodiscard]] double Ipc() const {
+            const bool both = measured[cycles] && measured[instructions] && values[cycles] > 0;
+            return both ? static_cast<double>(values[instructions]) / static_cast<double>(values[cycles]) : 0;
+        }
+
+        PerfCounts& operator+=(const PerfCounts& other) {
+            for (size_t i = 0; i < count; ++i) {
+                values[i] += other.values[i];
+                measured[i] = measured[i] || other.measured[i];
+            }
+            return *this;
+        }
+    };
+
+    /// Counters for the calling thread opened as one perf_event group so they cover the same instructions.
+    ///  Counters the cpu, the kernel or perf_event_paranoid don't allow are left out,
+    ///  the first one that opens leads the group
+    class PerfCounterGroup {
+        std::array<int, PerfCounts::count> fds;
+        std::array<std::uint64_t, PerfCounts::count> ids{};
+        int leader = -1;
+        std::string error;
+
+        static perf_event_attr Attribute(const size_t counter) {
+            perf_event_attr attribute{};
+            attribute.size = sizeof(attribute);
+            attribute.type = PERF_TYPE_HARDWARE;
+            const auto cache = [](const std::uint64_t which) {
+                return which | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            };
+            switch (counter) {
+                case PerfCounts::cycles:          attribute.config = PERF_COUNT_HW_CPU_CYCLES; break;
+                case PerfCounts::instructions:    attribute.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+                case PerfCounts::l1dMisses:       attribute.type = PERF_TYPE_HW_CACHE; attribute.config = cache(PERF_COUNT_HW_CACHE_L1D); break;
+                case PerfCounts::llcMisses:       attribute.type = PERF_TYPE_HW_CACHE; attribute.config = cache(PERF_COUNT_HW_CACHE_LL); break;
+                case PerfCounts::branchMisses:    attribute.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+                default:                          attribute.type = PERF_TYPE_SOFTWARE; attribute.config = PERF_COUNT_SW_CONTEXT_SWITCHES; break;
+            }
+            attribute.exclude_hv = 1;
+            attribute.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return attribute;
+        }
+
+        int Open(perf_event_attr attribute) const {
+            if (leader < 0) { attribute.disabled = 1; }
+            return static_cast<int>(syscall(SYS_perf_event_open, &attribute, 0, -1, leader, PERF_FLAG_FD_CLOEXEC));
+        }
+
+    public:
+        PerfCounterGroup() {
+            fds.fill(-1);
+            for (size_t counter = 0; counter < PerfCounts::count; ++counter) {
+                perf_event_attr attribute = Attribute(counter);
+                int fd = Open(attribute);
+                // Without permission for the kernel count what we can in user space,
+                //  except context switches which only happen in the kernel
+                if (fd < 0 && (errno == EACCES || errno == EPERM) && counter != PerfCounts::contextSwitches) {
+                    attribute.exclude_kernel = 1;
+                    fd = Open(attribute);
+                }
+                if (fd < 0) {
+                    error += std::string(error.empty() ? "" : ", ") + PerfCounts::Name(counter) + ": " + std::strerror(errno);
+                    continue;
+                }
+                if (ioctl(fd, PERF_EVENT_IOC_ID, &ids[counter]) != 0) {
+                    close(fd);
+                    continue;
+                }
+                fds[counter] = fd;
+                if (leader < 0) { leader = fd; }
+            }
+        }
+        ~PerfCounterGroup() {
+            for (const int fd : fds) {
+                if (fd >= 0) { close(fd); }
+            }
+        }
+        PerfCounterGroup(const PerfCounterGroup&) = delete;
+        PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+        [[nodiscard]] bool Available() const { return leader >= 0; }
+        /// Why counters are missing, empty if they all opened
+        [[nodiscard]] const std::string& Error() const { return error; }
+
+        void Start() {
+            if (!Available()) { return; }
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        /// False if nothing was counted, i.e. the group never got onto the cpu's counters
+        bool Stop(PerfCounts& counts) {
+            if (!Available()) { return false; }
+            ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            // nr, time enabled, time running, then a value and id per counter
+            std::array<std::uint64_t, 3 + 2 * PerfCounts::count> buffer{};
+            const ssize_t bytes = read(leader, buffer.data(), sizeof(buffer));
+            if (bytes < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) || buffer[2] == 0) { return false; }
+            // Scale up when the kernel had to multiplex the counters
+            const double scale = static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+            for (std::uint64_t i = 0; i < buffer[0] && i < PerfCounts::count; ++i) {
+                for (size_t counter = 0; counter < PerfCounts::count; ++counter) {
+                    if (fds[counter] < 0 || ids[counter] != buffer[4 + 2 * i]) { continue; }
+                    counts.values[counter] = static_cast<unsigned long long>(static_cast<double>(buffer[3 + 2 * i]) * scale);
+                    counts.measured[counter] = true;
+                }
+            }
+            return true;
+        }
+    };
+
+    /// Totals of the tests of each suite
+    struct PerfSuiteTotals {
+        size_t tests = 0;
+        PerfCounts counts;
+    };
+
+    /// Tab separated, a row per suite, only the counters that were measured
+    inline void WritePerfTable(std::ostream& out, const std::map<std::string, PerfSuiteTotals>& suites) {
+        PerfCounts any;
+        for (const auto& suite : suites) { any += suite.second.counts; }
+        out << "suite\ttests";
+        for (size_t counter = 0; counter < PerfCounts::count; ++counter) {
+            if (any.measured[counter]) { out << '\t' << PerfCounts::Name(counter); }
+        }
+        out << "\tipc\n";
+        for (const auto& suite : suites) {
+            out << suite.first << '\t' << suite.second.tests;
+            for (size_t counter = 0; counter < PerfCounts::count; ++counter) {
+                if (any.measured[counter]) { out << '\t' << suite.second.counts.values[counter]; }
+            }
+            out << '\t' << suite.second.counts.Ipc() << '\n';
+        }
+    }
+
+    /// Counts each test on the thread running the tests. A forked child opens its own counters,
+    ///  the suite totals come from the tests' perf_* properties so they include forked tests
+    struct PerfCounterRecorder : ::testing::EmptyTestEventListener {
+        std::unique_ptr<PerfCounterGroup> group;
+        pid_t owner = 0;
+        // Writes the table, children exit without it
+        pid_t parent = getpid();
+        bool reported = false;
+        std::map<std::string, PerfSuiteTotals> suites;
+
+        PerfCounterGroup& Group() {
+            if (!group || owner != getpid()) {
+                group.reset(new PerfCounterGroup{});
+                owner = getpid();
+                if (!group->Available() && !reported) {
+                    std::cout << "[ PERF     ] Performance counters are unavailable (" << group->Error()
+                              << "), check /proc/sys/kernel/perf_event_paranoid\n";
+                }
+                reported = true;
+            }
+            return *group;
+        }
+
+        void Stop() {
+            PerfCounts counts;
+            if (!Group().Stop(counts)) { return; }
+            for (size_t counter = 0; counter < PerfCounts::count; ++counter) {
+                if (counts.measured[counter]) {
+                    ::testing::Test::RecordProperty(std::string("perf_") + PerfCounts::Name(counter), std::to_string(counts.values[counter]));
+                }
+            }
+            if (counts.Ipc() > 0) { ::testing::Test::RecordProperty("perf_ipc", std::to_string(counts.Ipc())); }
+        }
+
+        void OnTestEnd(const ::testing::TestInfo& testInfo) override {
+            PerfCounts counts;
+            bool counted = false;
+            const auto* result = testInfo.result();
+            for (int i = 0; i < result->test_property_count(); ++i) {
+                const std::string key = result->GetTestProperty(i).key();
+                for (size_t counter = 0; counter < PerfCounts::count; ++counter) {
+                    if (key != std::string("perf_") + PerfCounts::Name(counter)) { continue; }
+                    counts.values[counter] = std::strtoull(result->GetTestProperty(i).value(), nullptr, 10);
+                    counts.measured[counter] = true;
+                    counted = true;
+                }
+            }
+            if (!counted) { return; }
+            auto& totals = suites[testInfo.test_suite_name()];
+            ++totals.tests;
+            totals.counts += counts;
+        }
+
+        /// Writes the table to CPPUNIT2GTEST_PERF_COUNTERS_OUTPUT, or prints it
+        void OnTestProgramEnd(const ::testing::UnitTest&) override {
+            if (suites.empty() || parent != getpid()) { return; }
+            const char* path = std::getenv("CPPUNIT2GTEST_PERF_COUNTERS_OUTPUT");
+            if (path == nullptr) {
+                std::cout << "[ PERF     ] Counts per suite\n";
+                WritePerfTable(std::cout, suites);
+                return;
+            }
+            std::ofstream out(path);
+            WritePerfTable(out, suites);
+        }
+    };
+
+    inline PerfCounterRecorder& PerfCounterRecorder_() {
+        // gtest owns the listener, it lives until the end of the program
+        static PerfCounterRecorder* recorder = []() {
+            auto* created = new PerfCounterRecorder{};
+            ::testing::UnitTest::GetInstance()->listeners().Append(created);
+            return created;
+        }();
+        return *recorder;
+    }
+
+    inline void InstallPerfCounters_() { (void)PerfCounterRecorder_(); }
+    inline void StartPerfCounters_() { PerfCounterRecorder_().Group().Start(); }
+    inline void StopPerfCounters_() { PerfCounterRecorder_().Stop(); }
+#endif // CppUnit2Gtest_EnablePerfCounters
+
+#if defined(CppUnit2Gtest_EnableSamplingProfiler)
+    /// Stacks captured by the SIGPROF handler, preallocated as the handler can't allocate.
+    ///  The frames are left uninitialized so only the pages the handler writes to take memory
+    struct StackSamples {
+        static constexpr int maxDepth = 64;
+        std::unique_ptr<void*[]> frames;
+        std::vector<int> depths;
+        std::atomic<size_t> next{0};
+        std::atomic<bool> armed{false};
+        /// The sampled thread and the bounds of its stack, frame pointers outside them aren't followed
+        long thread = 0;
+        std::uintptr_t stackLow = 0;
+        std::uintptr_t stackHigh = 0;
+
+        void Reset(const size_t capacity) {
+            frames.reset(new void*[capacity * maxDepth]);
+            depths.assign(capacity, 0);
+            next = 0;
+        }
+        [[nodiscard]] size_t Taken() const { return std::min(next.load(), depths.size()); }
+        [[nodiscard]] size_t Dropped() const { return next.load() - Taken(); }
+    };
+
+    inline StackSamples& StackSamples_() {
+        static StackSamples samples;
+        return samples;
+    }
+
+    /// Walks the frame pointer chain from where the signal interrupted the thread, leaf first.
+    ///  Only reads within [stackLow, stackHigh) and stops at the first frame without a frame pointer
+    ///  (build with -fno-omit-frame-pointer), so it is safe wherever the thread was
+    inline int WalkFrames_(const ucontext_t& context, void** frames, const int maxDepth,
+                           const std::uintptr_t stackLow, const std::uintptr_t stackHigh) {
+#   if defined(__x86_64__)
+        const auto pc = static_cast<std::uintptr_t>(context.uc_mcontext.gregs[REG_RIP]);
+        auto frame = static_cast<std::uintptr_t>(context.uc_mcontext.gregs[REG_RBP]);
+#   else
+        const auto pc = static_cast<std::uintptr_t>(context.uc_mcontext.pc);
+        auto frame = static_cast<std::uintptr_t>(context.uc_mcontext.regs[29]);
+#   endif
+        int depth = 0;
+        frames[depth++] = reinterpret_cast<void*>(pc);
+        // Each frame holds the caller's frame pointer then the return address, callers are further up the stack
+        while (depth < maxDepth && frame >= stackLow && frame <= stackHigh - 2 * sizeof(void*)
+               && frame % sizeof(void*) == 0) {
+            const auto* saved = reinterpret_cast<const std::uintptr_t*>(frame);
+            if (saved[1] == 0) { break; }
+            frames[depth++] = reinterpret_cast<void*>(saved[1]);
+            if (saved[0] <= frame) { break; }
+            frame = saved[0];
+        }
+        return depth;
+    }
+
+    inline void SampleStack_(int, siginfo_t*, void* context) {
+        // Only touches memory set up before the timer was armed
+        StackSamples& samples = StackSamples_();
+        if (!samples.armed.load()) { return; }
+        const int savedErrno = errno;
+        if (syscall(SYS_gettid) != samples.thread) {
+            errno = savedErrno;
+            return;
+        }
+        const size_t index = samples.next.fetch_add(1);
+        if (index < samples.depths.size()) {
+            samples.depths[index] = WalkFrames_(*static_cast<const ucontext_t*>(context),
+                &samples.frames[index * StackSamples::maxDepth], StackSamples::maxDepth, samples.stackLow, samples.stackHigh);
+        }
+        errno = savedErrno;
+    }
+
+    /// Function name of a return address, "[module]" when it has no exported symbol (link with -rdynamic)
+    inline std::string SymbolName_(void* address) {
+        std::unique_ptr<char*, decltype(&std::free)> symbols(backtrace_symbols(&address, 1), &std::free);
+        if (!symbols) { return "[unknown]"; }
+        // "module(mangled+0x1f) [0x...]"
+        const std::string symbol = symbols.get()[0];
+        const size_t open = symbol.find('(');
+        const size_t plus = symbol.find('+', open);
+        const size_t close = symbol.find(')', open);
+        if (open == std::string::npos || close == std::string::npos) { return symbol; }
+        const size_t slash = symbol.find_last_of('/', open);
+        const size_t moduleStart = slash == std::string::npos ? 0 : slash + 1;
+        const std::string module = symbol.substr(moduleStart, open - moduleStart);
+        if (plus == open + 1 || plus == std::string::npos || plus > close) { return "[" + module + "]"; }
+        const std::string mangled = symbol.substr(open + 1, plus - open - 1);
+        int status = 0;
+        std::unique_ptr<char, decltype(&std::free)> demangled(abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status), &std::free);
+        return status == 0 && demangled ? std::string(demangled.get()) : mangled;
+    }
+
+    /// Brendan Gregg's folded format, "root;caller;leaf count" per distinct stack
+    inline void WriteFoldedStacks(std::ostream& out, const StackSamples& samples) {
+        std::map<void*, std::string> names;
+        std::map<std::string, size_t> stacks;
+        for (size_t i = 0; i < samples.Taken(); ++i) {
+            std::string stack;
+            for (int frame = samples.depths[i] - 1; frame >= 0; --frame) {
+                void* address = samples.frames[i * StackSamples::maxDepth + static_cast<size_t>(frame)];
+                auto name = names.find(address);
+                if (name == names.end()) { name = names.emplace(address, SymbolName_(address)).first; }
+                // ';' separates frames and the count follows the last space
+                std::string cleaned = name->second;
+                for (char& c : cleaned) { c = c == ';' ? ':' : c; }
+                stack += (stack.empty() ? "" : ";") + cleaned;
+            }
+            if (!stack.empty()) { ++stacks[stack]; }
+        }
+        for (const auto& stack : stacks) { out << stack.first << ' ' << stack.second << '\n'; }
+    }
+
+    /// Settings from CPPUNIT2GTEST_SAMPLE_TESTS (a gtest filter), CPPUNIT2GTEST_SAMPLE_DIR, CPPUNIT2GTEST_SAMPLE_HZ
+    ///  and CPPUNIT2GTEST_SAMPLE_SECONDS (the cpu time a sampled test is expected to take, later samples are dropped)
+    struct SamplingProfiler {
+        std::string filter;
+        std::string directory = ".";
+        long hz = 997;
+        long seconds = 10;
+        std::string fileName;
+        timer_t timer{};
+
+        static SamplingProfiler* FromEnvironment() {
+            const char* filter = std::getenv("CPPUNIT2GTEST_SAMPLE_TESTS");
+            if (filter == nullptr || *filter == '\0') { return nullptr; }
+            auto* profiler = new SamplingProfiler{};
+            profiler->filter = filter;
+            if (const char* directory = std::getenv("CPPUNIT2GTEST_SAMPLE_DIR")) { profiler->directory = directory; }
+            if (const char* hz = std::getenv("CPPUNIT2GTEST_SAMPLE_HZ")) { profiler->hz = std::max(1L, std::min(1000L, std::atol(hz))); }
+            if (const char* seconds = std::getenv("CPPUNIT2GTEST_SAMPLE_SECONDS")) { profiler->seconds = std::max(1L, std::min(3600L, std::atol(seconds))); }
+            InstallHandler();
+            return profiler;
+        }
+
+        static void InstallHandler() {
+            struct sigaction action {};
+            action.sa_sigaction = &SampleStack_;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESTART | SA_SIGINFO;
+            sigaction(SIGPROF, &action, nullptr);
+        }
+
+        /// "<directory>/<Suite>.<test>.folded", typed and parameterised names keep their '/' as '_'
+        static std::string FileName(const std::string& directory, const std::string& suite, const std::string& test) {
+            std::string name = suite + "." + test;
+            for (char& c : name) { c = c == '/' ? '_' : c; }
+            return directory + "/" + name + ".folded";
+        }
+
+        /// Samples the calling thread, the one running the test, by the cpu time it uses
+        bool Start(const ::testing::TestInfo& test) {
+            if (!MatchesFilter_(filter, std::string(test.test_suite_name()) + "." + test.name())) { return false; }
+            fileName = FileName(directory, test.test_suite_name(), test.name());
+            StackSamples& samples = StackSamples_();
+            samples.Reset(static_cast<size_t>(hz * seconds));
+            if (!ThisThreadsStack(samples.stackLow, samples.stackHigh)) {
+                std::cerr << "Cannot find the stack of the test's thread, it isn't sampled\n";
+                return false;
+            }
+            samples.thread = syscall(SYS_gettid);
+            sigevent event{};
+            event.sigev_notify = SIGEV_THREAD_ID;
+            event.sigev_signo = SIGPROF;
+            // sigev_notify_thread_id, which older glibc headers don't define
+            event._sigev_un._tid = static_cast<pid_t>(samples.thread);
+            if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0) {
+                std::cerr << "Cannot create the sampling timer: " << std::strerror(errno) << '\n';
+                return false;
+            }
+            samples.armed = true;
+            itimerspec interval{};
+            interval.it_interval.tv_nsec = 1000000000L / hz;
+            interval.it_value = interval.it_interval;
+            timer_settime(timer, 0, &interval, nullptr);
+            return true;
+        }
+
+        void Stop() {
+            timer_delete(timer);
+            StackSamples& samples = StackSamples_();
+            samples.armed = false;
+            std::ofstream out(fileName);
+            WriteFoldedStacks(out, samples);
+            if (!out) { std::cerr << "Cannot write " << fileName << '\n'; }
+            std::cout << "[ SAMPLES  ] " << samples.Taken() << " stacks written to " << fileName;
+            if (samples.Dropped() > 0) { std::cout << " (" << samples.Dropped() << " dropped, raise CPPUNIT2GTEST_SAMPLE_SECONDS)"; }
+            std::cout << '\n';
+        }
+
+        static bool ThisThreadsStack(std::uintptr_t& low, std::uintptr_t& high) {
+            pthread_attr_t attributes;
+            if (pthread_getattr_np(pthread_self(), &attributes) != 0) { return false; }
+            void* stack = nullptr;
+            size_t size = 0;
+            const bool found = pthread_attr_getstack(&attributes, &stack, &size) == 0;
+            pthread_attr_destroy(&attributes);
+            low = reinterpret_cast<std::uintptr_t>(stack);
+            high = low + size;
+            return found;
+        }
+    };
+
+    inline SamplingProfiler* EnvironmentSamplingProfiler_() {
+        // Deliberately leaked, it is used until the end of the program
+        static SamplingProfiler* profiler = SamplingProfiler::FromEnvironment();
+        return profiler;
+    }
+
+    inline bool StartSampling_() {
+        SamplingProfiler* profiler = EnvironmentSamplingProfiler_();
+        const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+        return profiler != nullptr && testInfo != nullptr && profiler->Start(*testInfo);
+    }
+
+    inline void StopSampling_() { EnvironmentSamplingProfiler_()->Stop(); }
+#endif // CppUnit2Gtest_EnableSamplingProfiler
+
+#if defined(CppUnit2Gtest_EnableTracing)
+    /// Appends Chrome Trace Event JSON (array format, ui.perfetto.dev and chrome://tracing open it) to a file.
+    ///  Threads buffer their events and write them in chunks, forked children share the file and show as processes
+    class TraceWriter {
+        std::FILE* file = nullptr;
+        std::mutex mutex;
+        long ownerProcess = 0;
+        bool closed = false;
+        std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+    public:
+        explicit TraceWriter(const std::string& path) : ownerProcess(static_cast<long>(CppUnit2Gtest_getpid_())) {
+            if (std::FILE* truncated = std::fopen(path.c_str(), "w")) {
+                std::fputs("[\n", truncated);
+                std::fclose(truncated);
+                // Appending keeps the writes of forked children whole
+                file = std::fopen(path.c_str(), "a");
+            }
+        }
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+
+        [[nodiscard]] bool IsOpen() const { return file != nullptr; }
+
+        [[nodiscard]] double Now() const {
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+        }
+
+        void Write(const std::string& chunk) {
+            const std::lock_guard<std::mutex> lock(mutex);
+            if (file == nullptr || closed || chunk.empty()) { return; }
+            std::fwrite(chunk.data(), 1, chunk.size(), file);
+            std::fflush(file);
+        }
+
+        /// Ends the array, the bracket is optional so a crashed run is still readable.
+        ///  Only the process that started tracing closes it
+        void Close(const std::string& lastChunk) {
+            if (static_cast<long>(CppUnit2Gtest_getpid_()) != ownerProcess) { return; }
+            Write(lastChunk + "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(ownerProcess)
+                + ",\"args\":{\"name\":\"CppUnit2Gtest\"}}\n]\n");
+            const std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+    };
+
+    inline TraceWriter* TraceWriter_();
+
+    /// Events of one thread waiting to be written
+    struct ThreadTraceBuffer {
+        static constexpr size_t chunkEvents = 64;
+        std::string events;
+        size_t count = 0;
+        long process = static_cast<long>(CppUnit2Gtest_getpid_());
+        int thread = NextThreadId();
+
+        static int NextThreadId() {
+            static std::atomic<int> next{1};
+            return next++;
+        }
+
+        /// The events, if they belong to this process (a forked child drops what it copied from its parent)
+        std::string Take() {
+            std::string taken;
+            if (process == static_cast<long>(CppUnit2Gtest_getpid_())) { taken.swap(events); }
+            events.clear();
+            count = 0;
+            process = static_cast<long>(CppUnit2Gtest_getpid_());
+            return taken;
+        }
+        void Flush() {
+            if (TraceWriter* writer = TraceWriter_()) { writer->Write(Take()); }
+        }
+        ~ThreadTraceBuffer() { Flush(); }
+    };
+
+    inline ThreadTraceBuffer& TraceBuffer_() {
+        thread_local ThreadTraceBuffer buffer;
+        return buffer;
+    }
+
+    inline void FlushTrace_() { TraceBuffer_().Flush(); }
+
+    inline std::string TraceEscape_(const std::string& text) {
+        std::string escaped;
+        for (const char c : text) {
+            if (c == '"' || c == '\\') { escaped += '\\'; }
+            escaped += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+        }
+        return escaped;
+    }
+
+    inline void TraceComplete_(const char* category, const std::string& name, const double start, const double end) {
+        ThreadTraceBuffer& buffer = TraceBuffer_();
+        if (buffer.process != static_cast<long>(CppUnit2Gtest_getpid_())) { (void)buffer.Take(); }
+        std::ostringstream event;
+        event.setf(std::ios::fixed);
+        event.precision(3);
+        event << "{\"name\":\"" << TraceEscape_(name) << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"ts\":" << start
+              << ",\"dur\":" << (end - start) << ",\"pid\":" << buffer.process << ",\"tid\":" << buffer.thread << "},\n";
+        buffer.events += event.str();
+        if (++buffer.count >= ThreadTraceBuffer::chunkEvents) { buffer.Flush(); }
+    }
+
+    /// Traces what gtest runs around the CppUnit methods: each suite and each whole test
+    struct TraceListener : ::testing::EmptyTestEventListener {
+        TraceWriter& writer;
+        double suiteStart = 0;
+        double testStart = 0;
+        explicit TraceListener(TraceWriter& writer_) : writer(writer_) {}
+
+        void OnTestSuiteStart(const ::testing::TestSuite&) override { suiteStart = writer.Now(); }
+        void OnTestStart(const ::testing::TestInfo&) override { testStart = writer.Now(); }
+        void OnTestEnd(const ::testing::TestInfo& test) override {
+            TraceComplete_("test", std::string(test.test_suite_name()) + "." + test.name(), testStart, writer.Now());
+            TraceBuffer_().Flush();
+        }
+        void OnTestSuiteEnd(const ::testing::TestSuite& suite) override {
+            TraceComplete_("suite", suite.name(), suiteStart, writer.Now());
+            TraceBuffer_().Flush();
+        }
+        void OnTestProgramEnd(const ::testing::UnitTest&) override { writer.Close(TraceBuffer_().Take()); }
+    };
+
+    /// Writer for CPPUNIT2GTEST_TRACE_FILE, or nullptr
+    inline TraceWriter* TraceWriter_() {
+        // Deliberately leaked, threads and static destructors may still flush into it
+        static TraceWriter* writer = []() -> TraceWriter* {
+            const char* path = std::getenv("CPPUNIT2GTEST_TRACE_FILE");
+            if (path == nullptr || *path == '\0') { return nullptr; }
+            auto* created = new TraceWriter(path);
+            if (!created->IsOpen()) {
+                std::cerr << "Cannot write the trace to " << path << '\n';
+                delete created;
+                return nullptr;
+            }
+            ::testing::UnitTest::GetInstance()->listeners().Append(new TraceListener(*created));
+            return created;
+        }();
+        return writer;
+    }
+
+    inline bool Tracing_() { return TraceWriter_() != nullptr; }
+    inline double TraceNow_() { return TraceWriter_()->Now(); }
+#endif // CppUnit2Gtest_EnableTracing
+
+#if defined(CppUnit2Gtest_EnableGoldenFiles)
+#   if !defined(CppUnit2Gtest_GoldenBlockSize)
+/// Bytes compared with one memcmp before looking for the exact difference
+#       define CppUnit2Gtest_GoldenBlockSize (1u << 20)
+#   endif
+#   if !defined(CppUnit2Gtest_GoldenDiffWidth)
+/// Most characters of a line or bytes of a hex dump shown around a difference
+#       define CppUnit2Gtest_GoldenDiffWidth 96
+#   endif
+
+    /// Offset of the first byte that differs, the shorter size if one file is a prefix of the other
+    inline size_t FirstDifference_(const MappedFile& a, const MappedFile& b) {
+        const size_t common = std::min(a.Size(), b.Size());
+        size_t block = 0;
+        while (block < common) {
+            const size_t length = std::min<size_t>(CppUnit2Gtest_GoldenBlockSize, common - block);
+            if (std::memcmp(a.Data() + block, b.Data() + block, length) != 0) {
+                return static_cast<size_t>(std::mismatch(a.Data() + block, a.Data() + block + length, b.Data() + block).first - a.Data());
+            }
+            block += length;
+        }
+        return common;
+    }
+
+    inline bool LooksLikeText_(const char* data, const size_t size) {
+        return std::none_of(data, data + size, [](const char c) {
+            const auto byte = static_cast<unsigned char>(c);
+            return byte < 0x20 && byte != '\n' && byte != '\r' && byte != '\t';
+        });
+    }
+
+    /// The line of the file around offset, cut to the diff width, with where offset falls in it
+    inline std::string LineAround_(const MappedFile& file, const size_t offset, size_t& caret) {
+        const char* begin = file.Data();
+        const char* end = begin + file.Size();
+        const char* at = begin + std::min(offset, file.Size());
+        const char* lineBegin = at;
+        while (lineBegin > begin && lineBegin[-1] != '\n') { --lineBegin; }
+        const char* lineEnd = std::find(at, end, '\n');
+        const auto half = static_cast<std::ptrdiff_t>(CppUnit2Gtest_GoldenDiffWidth / 2);
+        const char* from = at - lineBegin > half ? at - half : lineBegin;
+        const char* to = std::min(lineEnd, from + CppUnit2Gtest_GoldenDiffWidth);
+        caret = static_cast<size_t>(at - from);
+        std::string line(from, to);
+        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+        return (from != lineBegin ? "..." : "") + line + (to != lineEnd ? "..." : "");
+    }
+
+    inline void HexDump_(std::ostream& out, const char* name, const MappedFile& file, const size_t first, const size_t offset) {
+        static const char digits[] = "0123456789abcdef";
+        out << "  " << name << ':';
+        const size_t last = std::min(file.Size(), first + CppUnit2Gtest_GoldenDiffWidth / 3);
+        for (size_t i = first; i < last; ++i) {
+            const auto byte = static_cast<unsigned char>(file.Data()[i]);
+            out << (i == offset ? '[' : ' ') << digits[byte >> 4] << digits[byte & 0xf];
+        }
+        if (offset >= last) { out << " [end]"; }
+        out << '\n';
+    }
+
+    /// Describes the first difference as a line and column with both lines, or as a hex dump when either side is binary
+    inline std::string DescribeDifference_(const MappedFile& actual, const MappedFile& expected, const size_t offset) {
+        std::ostringstream out;
+        const char* lineStart = actual.Data() + offset;
+        const auto line = 1 + std::count(actual.Data(), lineStart, '\n');
+        while (lineStart > actual.Data() && lineStart[-1] != '\n') { --lineStart; }
+        out << "first difference at byte " << offset << " (line " << line << ", column "
+            << (actual.Data() + offset - lineStart + 1) << ")";
+        if (actual.Size() != expected.Size()) {
+            out << ", sizes " << actual.Size() << " and " << expected.Size() << " bytes";
+        }
+        out << '\n';
+        const size_t first = offset - std::min<size_t>(offset, CppUnit2Gtest_GoldenDiffWidth / 6);
+        const auto around = [&](const MappedFile& file) {
+            const size_t from = std::min(first, file.Size());
+            return LooksLikeText_(file.Data() + from, std::min(file.Size(), first + CppUnit2Gtest_GoldenDiffWidth) - from);
+        };
+        if (around(actual) && around(expected)) {
+            size_t caret = 0;
+            out << "  actual:   " << LineAround_(actual, offset, caret) << '\n';
+            out << "  expected: " << LineAround_(expected, offset, caret) << '\n';
+            out << "            " << std::string(caret, ' ') << '^';
+        } else {
+            HexDump_(out, "actual  ", actual, first, offset);
+            HexDump_(out, "expected", expected, first, offset);
+        }
+        return out.str();
+    }
+
+    inline ::testing::AssertionResult CompareFiles_(const std::string& actualPath, const std::string& expectedPath) {
+        const MappedFile actual(actualPath);
+        const MappedFile expected(expectedPath);
+        if (!actual.Error().empty()) { return ::testing::AssertionFailure() << actual.Error(); }
+        if (!expected.Error().empty()) { return ::testing::AssertionFailure() << expected.Error(); }
+        const size_t offset = FirstDifference_(actual, expected);
+        if (offset == actual.Size() && offset == expected.Size()) { return ::testing::AssertionSuccess(); }
+        return ::testing::AssertionFailure()
+            << actualPath << " differs from " << expectedPath << ", " << DescribeDifference_(actual, expected, offset);
+    }
+
+    /// Golden files are rewritten instead of compared when CPPUNIT2GTEST_UPDATE_GOLDEN is set and not 0
+    inline bool UpdatingGoldenFiles_() {
+        const char* update = std::getenv("CPPUNIT2GTEST_UPDATE_GOLDEN");
+        return update != nullptr && *update != '\0' && std::string(update) != "0";
+    }
+
+    /// Copies actual over golden through a temporary file so an interrupted update never leaves half a golden file
+    inline ::testing::AssertionResult UpdateGolden_(const std::string& actualPath, const std::string& goldenPath) {
+        const MappedFile actual(actualPath);
+        if (!actual.Error().empty()) { return ::testing::AssertionFailure() << actual.Error(); }
+        const std::string temporary = goldenPath + ".update";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(actual.Data(), static_cast<std::streamsize>(actual.Size()));
+            if (!out) { return ::testing::AssertionFailure() << "cannot write " << temporary; }
+        }
+        if (std::rename(temporary.c_str(), goldenPath.c_str()) != 0) {
+            const std::string error = std::strerror(errno);
+            std::remove(temporary.c_str());
+            return ::testing::AssertionFailure() << "cannot replace " << goldenPath << ": " << error;
+        }
+        ::testing::Test::RecordProperty("golden_updated", goldenPath);
+        return ::testing::AssertionSuccess();
+    }
+
+    /// Predicate formatters for the wrapper's PRED_FORMAT2
+    inline ::testing::AssertionResult FilesEqual_(const char*, const char*, const std::string& actualPath, const std::string& expectedPath) {
+        return CompareFiles_(actualPath, expectedPath);
+    }
+
+    inline ::testing::AssertionResult MatchesGolden_(const char*, const char*, const std::string& actualPath, const std::string& goldenPath) {
+        if (UpdatingGoldenFiles_()) { return UpdateGolden_(actualPath, goldenPath); }
+        auto result = CompareFiles_(actualPath, goldenPath);
+        if (!result) { result << "\n  rerun with CPPUNIT2GTEST_UPDATE_GOLDEN=1 to accept the actual file"; }
+        return result;
+    }
+#endif // CppUnit2Gtest_EnableGoldenFiles
+
+#if defined(CppUnit2Gtest_EnableRegistrationStats)
+    /// Every suite registered so far, in registration order
+    inline std::vector<RegistrationStats>& AllRegistrationStats() {
+        static std::vector<RegistrationStats> all;
+        return all;
+    }
+
+    /// The registration of the named suite, empty if it wasn't registered by InternalRegisterTests
+    inline RegistrationStats FindRegistrationStats(const std::string& suite) {
+        for (const auto& stats : AllRegistrationStats()) {
+            if (stats.suite == suite) { return stats; }
+        }
+        return {};
+    }
+
+    /// Sums of the suites registered by each file, the suite names the file's slowest suite
+    inline std::vector<RegistrationStats> RegistrationStatsByFile() {
+        std::map<std::string, RegistrationStats> files;
+        std::map<std::string, double> slowest;
+        for (const auto& stats : AllRegistrationStats()) {
+            auto& file = files[stats.file];
+            file.file = stats.file;
+            file.tests += stats.tests;
+            file.milliseconds += stats.milliseconds;
+            file.allocations += stats.allocations;
+            if (file.suite.empty() || stats.milliseconds > slowest[stats.file]) {
+                file.suite = stats.suite;
+                slowest[stats.file] = stats.milliseconds;
+            }
+        }
+        std::vector<RegistrationStats> byFile;
+        for (auto& file : files) { byFile.push_back(std::move(file.second)); }
+        return byFile;
+    }
+
+    /// Tab separated tables of the files then the suites, slowest first
+    inline void WriteRegistrationReport(std::ostream& out) {
+        const auto slowestFirst = [](const RegistrationStats& a, const RegistrationStats& b) { return a.milliseconds > b.milliseconds; };
+        auto files = RegistrationStatsByFile();
+        std::stable_sort(files.begin(), files.end(), slowestFirst);
+        out << "file\tms\tallocations\ttests\tslowest suite\n";
+        for (const auto& file : files) {
+            out << file.file << '\t' << file.milliseconds << '\t' << file.allocations << '\t' << file.tests << '\t' << file.suite << '\n';
+        }
+        auto suites = AllRegistrationStats();
+        std::stable_sort(suites.begin(), suites.end(), slowestFirst);
+        out << "\nsuite\tms\tallocations\ttests\tfile\n";
+        for (const auto& suite : suites) {
+            out << suite.suite << '\t' << suite.milliseconds << '\t' << suite.allocations << '\t' << suite.tests << '\t' << suite.file << '\n';
+        }
+        if (!AllocationCounterInstalled_()) {
+            out << "\nAllocations are not counted, define CppUnit2Gtest_CountAllocations in one translation unit to count them\n";
+        }
+    }
 
-#define CppUnit2Gtest
-#define CppUnit2Gtest_VERSION   "0.0.0"
-#define CPPUNIT_VERSION         "CppUnit2Gtest"
-#define CPPUNIT_NS              ::CppUnit
-#define CPPUNIT_NS_BEGIN        namespace CppUnit {
-#define CPPUNIT_NS_END          }
+    /// Writes the report once static initialization is over, to the file in
+    ///  CPPUNIT2GTEST_REGISTRATION_REPORT or to stdout if it is "-"
+    struct RegistrationReportListener : ::testing::EmptyTestEventListener {
+        std::string path;
+        explicit RegistrationReportListener(std::string path_) : path(std::move(path_)) {}
 
-namespace CppUnit {
+        void OnTestProgramStart(const ::testing::UnitTest&) override {
+            if (path == "-") {
+                WriteRegistrationReport(std::cout);
+                return;
+            }
+            std::ofstream out(path);
+            WriteRegistrationReport(out);
+        }
+    };
 
-    class TestCase : public testing::Test
-    {
-    public:
-        // Take Cppunit style functions
-        virtual void setUp() {}
-        virtual void tearDown() {}
+    inline void RecordRegistration_(RegistrationStats stats) {
+        // gtest owns the listener, the first registration adds it
+        static const bool installed = []() {
+            const char* path = std::getenv("CPPUNIT2GTEST_REGISTRATION_REPORT");
+            if (path == nullptr || *path == '\0') { return false; }
+            ::testing::UnitTest::GetInstance()->listeners().Append(new RegistrationReportListener(path));
+            return true;
+        }();
+        static_cast<void>(installed);
+        AllRegistrationStats().push_back(std::move(stats));
+    }
+#endif // CppUnit2Gtest_EnableRegistrationStats
 
-        // Name forward to gtest equivalents
-        void SetUp() override { setUp(); }
-        void TearDown() override { tearDown(); }
+#if defined(CppUnit2Gtest_EnablePlugins)
+    /// A shared object loaded by LoadTestPlugin. It is never unloaded as gtest keeps its tests
+    struct TestPlugin {
+        std::string path;
+        /// Tests its suites registered while it loaded
+        int tests = 0;
+        /// Why it couldn't be used, empty if it loaded
+        std::string error;
     };
 
-    using TestFixture = TestCase;
-// CppUnit does some odd things in the name of portability
-//  We end up undoing them by default (ironically to maintain portability)
-/// Define to avoid the CppUnit::OStream being defined (allows for user defined custom streams)
-#ifndef Cppunit2Gtest_NoDeclOStream
-#   if defined(Cppunit2Gtest_StreamType)
-        using OStream = Cppunit2Gtest_StreamType;
-#   else
-        using OStream = std::ostream;
-#   endif
-#   if defined(Cppunit2Gtest_CustomCout)
-        inline auto stdCOut() { return Cppunit2Gtest_CustomCout; }
-#   else
-        inline auto& stdCOut() { return std::cout; }
+    /// Loads a plugin built with CPPUNIT_PLUGIN_IMPLEMENT, its suites register into this process as it loads
+    inline TestPlugin LoadTestPlugin(const std::string& path) {
+        TestPlugin plugin;
+        plugin.path = path;
+        const auto* unitTest = ::testing::UnitTest::GetInstance();
+        const int before = unitTest->total_test_count();
+        void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr) {
+            plugin.error = dlerror();
+            return plugin;
+        }
+        using PluginUnitTest = const void* (*)();
+        const auto pluginUnitTest = reinterpret_cast<PluginUnitTest>(dlsym(handle, "CppUnit2Gtest_PluginUnitTest"));
+        if (pluginUnitTest == nullptr) {
+            plugin.error = "not a test plugin, add CPPUNIT_PLUGIN_IMPLEMENT() to one of its files";
+        } else if (pluginUnitTest() != unitTest) {
+            plugin.error = "it registered into its own copy of gtest, link it against the runner (see cppunit2gtest_add_test_plugin)";
+        }
+        plugin.tests = unitTest->total_test_count() - before;
+        return plugin;
+    }
+
+    inline bool IsPluginName_(const std::string& name) {
+        const auto extension = name.rfind('.');
+        return extension != std::string::npos
+            && (name.compare(extension, std::string::npos, ".so") == 0 || name.compare(extension, std::string::npos, ".dylib") == 0);
+    }
+
+    /// The shared objects of a directory in name order, or the path itself if it isn't a directory
+    inline std::vector<std::string> PluginPaths_(const std::string& path) {
+        std::vector<std::string> paths;
+        if (DIR* directory = opendir(path.c_str())) {
+            while (const dirent* entry = readdir(directory)) {
+                if (IsPluginName_(entry->d_name)) { paths.push_back(path + "/" + entry->d_name); }
+            }
+            closedir(directory);
+            std::sort(paths.begin(), paths.end());
+        } else {
+            paths.push_back(path);
+        }
+        return paths;
+    }
+
+    /// Loads a plugin, or every shared object of a directory in name order
+    inline std::vector<TestPlugin> LoadTestPlugins(const std::string& path) {
+        std::vector<TestPlugin> plugins;
+        for (const auto& plugin : PluginPaths_(path)) { plugins.push_back(LoadTestPlugin(plugin)); }
+        return plugins;
+    }
+
+#   if defined(CppUnit2Gtest_EnableWatch)
+    inline int WatchTests(const std::vector<std::string>& paths, std::string filter, int commandsFd);
 #   endif
-#endif
 
-namespace to { namespace gtest {
-    // Stream operators make things forward compatable with gtest
-    struct ExitingAssertion : std::stringstream { };
-#define CppUnit2Gtest_CHECK(condition) \
-        if (!(condition)) { \
-            throw std::runtime_error("Internal Check failed when running test harness " #condition ); \
+    /// Main of a plugin runner: loads the plugins (files or directories) given as arguments and in
+    ///  CPPUNIT2GTEST_PLUGINS (separated by ':'), then runs all their tests. Fails if any doesn't load
+    inline int RunTestPlugins(int argc, char** argv) {
+        ::testing::InitGoogleTest(&argc, argv);
+        std::vector<std::string> paths(argv + 1, argv + argc);
+        if (const char* fromEnvironment = std::getenv("CPPUNIT2GTEST_PLUGINS")) {
+            std::string list = fromEnvironment;
+            size_t start = 0;
+            while (start <= list.size()) {
+                const size_t end = std::min(list.find(':', start), list.size());
+                if (end > start) { paths.push_back(list.substr(start, end - start)); }
+                start = end + 1;
+            }
+        }
+        if (paths.empty()) {
+            std::cerr << "Usage: " << argv[0] << " [gtest flags] <plugin or directory of plugins>...\n";
+            return 1;
+        }
+#   if defined(CppUnit2Gtest_EnableWatch)
+        const char* watch = std::getenv("CPPUNIT2GTEST_WATCH");
+        if (watch != nullptr && *watch != '\0' && std::string(watch) != "0") {
+            return WatchTests(paths, ::testing::GTEST_FLAG(filter), STDIN_FILENO);
+        }
+#   endif
+        bool loaded = true;
+        for (const auto& path : paths) {
+            for (const auto& plugin : LoadTestPlugins(path)) {
+                if (!plugin.error.empty()) {
+                    std::cerr << "[ PLUGIN   ] " << plugin.path << ": " << plugin.error << '\n';
+                    loaded = false;
+                    continue;
+                }
+                std::cout << "[ PLUGIN   ] " << plugin.path << ": " << plugin.tests << " tests\n";
+            }
         }
+        if (!loaded) { return 1; }
+#   if defined(CppUnit2Gtest_EnablePrioritization)
+        RegisterPrioritizedTests();
+#   endif
+        return RUN_ALL_TESTS();
+    }
+#endif // CppUnit2Gtest_EnablePlugins
 
-    /// Holds data required for each test.
-    template<typename FromClass>
-    struct TestData {
-        using TestMethodType = void(*)(FromClass&);
-        TestMethodType testMethod;
-        unsigned int line = 0;
-        const char* testName;
+#if defined(CppUnit2Gtest_EnableWatch)
+/// Changes that arrive within this many milliseconds of each other are run together (a link writes in bursts)
+#   ifndef CppUnit2Gtest_WatchSettleMs
+#       define CppUnit2Gtest_WatchSettleMs 100
+#   endif
 
-        TestData(const TestMethodType testMethod_, const unsigned int line_, const char* testName_)
-            : testMethod(testMethod_)
-            , line(line_)
-            , testName(testName_)
-        {
-            CppUnit2Gtest_CHECK(testMethod != nullptr);
-            CppUnit2Gtest_CHECK(testName != nullptr);
-            CppUnit2Gtest_CHECK(testName_ != nullptr);
+    /// Runs an artifact in a fresh worker and returns its exit code. A plugin is loaded into a forked child
+    ///  so only its own suites are registered, anything else is executed as a test binary
+    inline int RunWatchedArtifact_(const std::string& path, const std::string& filter) {
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        const bool plugin = IsPluginName_(path);
+        const pid_t child = fork();
+        if (child < 0) { return -1; }
+        if (child == 0) {
+            if (!plugin) {
+                const std::string filterFlag = "--gtest_filter=" + filter;
+                execl(path.c_str(), path.c_str(), filterFlag.c_str(), static_cast<char*>(nullptr));
+                std::cerr << "[ WATCH    ] Cannot run " << path << ": " << std::strerror(errno) << std::endl;
+                _exit(127);
+            }
+            const auto loaded = LoadTestPlugin(path);
+            if (!loaded.error.empty()) {
+                std::cerr << "[ WATCH    ] " << path << ": " << loaded.error << std::endl;
+                _exit(1);
+            }
+            ::testing::GTEST_FLAG(filter) = filter;
+            const int result = RUN_ALL_TESTS();
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+            _exit(result);
         }
+        int status = 0;
+        while (waitpid(child, &status, 0) < 0) {
+            if (errno != EINTR) { return -1; }
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
 
-        TestData(const TestData&) = default;
-        TestData(TestData&&) = default;
-        TestData& operator=(const TestData&) = default;
-        TestData& operator=(TestData&&) = default;
-        // Allow casting to another class type that inherits the current one
-        template<typename Derived>
-        explicit TestData(TestData<Derived>& from)
-            : testMethod(TestMethodType(from.testMethod))
-            , line(from.line)
-            , testName(from.testName)
-        {
-            CppUnit2Gtest_CHECK(testMethod != nullptr);
-            CppUnit2Gtest_CHECK(testName != nullptr);
-            CppUnit2Gtest_CHECK(from.testMethod != nullptr);
+    /// Runs each artifact in turn, reporting how long each took
+    inline void RunWatchedArtifacts_(const std::vector<std::string>& artifacts, const std::string& filter) {
+        for (const auto& artifact : artifacts) {
+            std::cout << "[ WATCH    ] Running " << artifact << " with filter " << filter << std::endl;
+            const auto start = std::chrono::steady_clock::now();
+            const int result = RunWatchedArtifact_(artifact, filter);
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            std::cout << "[ WATCH    ] " << artifact << (result == 0 ? " passed" : " failed with " + std::to_string(result))
+                      << " (" << elapsed.count() << " ms)" << std::endl;
         }
-    };
+    }
 
-    /// Includes the TestBody entry point that gtest runs
-    template<typename TestSuite>
-    struct DynamicTest : TestSuite {
-        using TestSuite::TestSuite;
-        using TestMethod = typename TestData<TestSuite>::TestMethodType;
-        TestMethod testMethod;
-        explicit DynamicTest(TestMethod testMethod_) : testMethod(testMethod_) {}
-        void TestBody() override {
-            // We inherit from this so safe to cast.
-            auto& a = static_cast<TestSuite&>(*this);
-            try {
-                (testMethod)(a);
-            } catch (const ExitingAssertion& e) {
-                // Hack to get around non-exiting assertions
-                //  Mostly only needed when CppUnit2Gtest_AllowAssertsInConstructors is on
-                FAIL() << e.str();
+    /// Watches test binaries and plugins (or directories of plugins) with inotify and reruns each one in a
+    ///  fresh worker once it is rebuilt, only a changed plugin's suites run (a binary reruns whole). Everything runs once at the start.
+    ///  A line read from commandsFd replaces the gtest filter (kept for later runs) and reruns everything,
+    ///  "q" or the end of its input stops watching
+    inline int WatchTests(const std::vector<std::string>& paths, std::string filter, const int commandsFd) {
+        if (filter.empty()) { filter = "*"; }
+        const int watcher = inotify_init1(IN_CLOEXEC);
+        if (watcher < 0) {
+            std::cerr << "[ WATCH    ] Cannot watch files: " << std::strerror(errno) << '\n';
+            return 1;
+        }
+        // Linkers often replace the file, so its directory is watched. An empty name watches its plugins
+        struct Watched { std::string directory; std::string name; std::string path; };
+        std::map<int, std::vector<Watched>> watches;
+        for (const auto& path : paths) {
+            struct stat status {};
+            const bool directory = stat(path.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+            const auto slash = path.rfind('/');
+            Watched watched{directory ? path : (slash == std::string::npos ? "." : path.substr(0, slash)),
+                            directory ? "" : path.substr(slash == std::string::npos ? 0 : slash + 1), path};
+            const int watch = inotify_add_watch(watcher, watched.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (watch < 0) {
+                std::cerr << "[ WATCH    ] Cannot watch " << watched.directory << ": " << std::strerror(errno) << '\n';
+                close(watcher);
+                return 1;
+            }
+            watches[watch].push_back(watched);
+        }
+        const auto everything = [&paths]() {
+            std::vector<std::string> artifacts;
+            for (const auto& path : paths) {
+                for (auto& artifact : PluginPaths_(path)) { artifacts.push_back(std::move(artifact)); }
+            }
+            return artifacts;
+        };
+        // Adds the artifacts named by the events in buffer, in the order they changed
+        const auto changedBy = [&watches](const char* buffer, const ssize_t length, std::vector<std::string>& changed) {
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                const std::string name = event->len > 0 ? event->name : "";
+                for (const auto& watched : watches[event->wd]) {
+                    const bool matches = watched.name.empty() ? IsPluginName_(name) : name == watched.name;
+                    const std::string artifact = watched.name.empty() ? watched.directory + "/" + name : watched.path;
+                    if (matches && std::find(changed.begin(), changed.end(), artifact) == changed.end()) {
+                        changed.push_back(artifact);
+                    }
+                }
+            }
+        };
+
+        RunWatchedArtifacts_(everything(), filter);
+        std::cout << "[ WATCH    ] Watching for changes, type a gtest filter to change it or q to stop" << std::endl;
+        alignas(inotify_event) char buffer[16384];
+        std::string command;
+        while (true) {
+            pollfd fds[2] = {{watcher, POLLIN, 0}, {commandsFd, POLLIN, 0}};
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) { continue; }
+                break;
+            }
+            if (fds[1].revents != 0) {
+                char c = 0;
+                const auto received = read(commandsFd, &c, 1);
+                if (received <= 0) { break; }
+                if (c != '\n') {
+                    command += c;
+                    continue;
+                }
+                if (command == "q") { break; }
+                filter = command.empty() ? filter : command;
+                command.clear();
+                RunWatchedArtifacts_(everything(), filter);
+                continue;
+            }
+            std::vector<std::string> changed;
+            // Collect changes until the files settle
+            for (pollfd settling{watcher, POLLIN, 0}; poll(&settling, 1, CppUnit2Gtest_WatchSettleMs) > 0;) {
+                const auto length = read(watcher, buffer, sizeof(buffer));
+                if (length <= 0) { break; }
+                changedBy(buffer, length, changed);
             }
+            RunWatchedArtifacts_(changed, filter);
+        }
+        close(watcher);
+        return 0;
+    }
+#endif // CppUnit2Gtest_EnableWatch
+
+#if defined(CppUnit2Gtest_EnableRetries)
+    inline int Retries_(const Properties& properties) {
+        const std::string* property = FindProperty(properties, "retries");
+        const char* environment = std::getenv("CPPUNIT2GTEST_RETRIES");
+        const int retries = property != nullptr ? std::atoi(property->c_str())
+            : environment != nullptr ? std::atoi(environment) : 0;
+        return retries > 0 ? retries : 0;
+    }
+
+    inline void RunAttemptStage_(::testing::TestPartResultArray& results, const std::function<void()>& stage, const char* where) {
+        // Other threads report to the global reporter, this one to its own (which might have been replaced)
+        ::testing::ScopedFakeTestPartResultReporter allThreads(
+            ::testing::ScopedFakeTestPartResultReporter::INTERCEPT_ALL_THREADS, &results);
+        ::testing::ScopedFakeTestPartResultReporter thisThread(
+            ::testing::ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD, &results);
+        try {
+            stage();
+        } catch (const std::exception& e) {
+            ADD_FAILURE() << "C++ exception with description \"" << e.what() << "\" thrown in " << where << ".";
+        } catch (...) {
+            ADD_FAILURE() << "Unknown C++ exception thrown in " << where << ".";
+        }
+    }
+
+    inline bool AttemptFailed_(const ::testing::TestPartResultArray& results) {
+        for (int i = 0; i < results.size(); ++i) {
+            if (results.GetTestPartResult(i).failed()) { return true; }
+        }
+        return false;
+    }
+
+    inline bool AttemptStopped_(const ::testing::TestPartResultArray& results) {
+        for (int i = 0; i < results.size(); ++i) {
+            if (results.GetTestPartResult(i).fatally_failed() || results.GetTestPartResult(i).skipped()) { return true; }
+        }
+        return false;
+    }
+
+    inline void ReportAttempt_(const ::testing::TestPartResultArray& results) {
+        for (int i = 0; i < results.size(); ++i) {
+            const auto& result = results.GetTestPartResult(i);
+            if (result.type() == ::testing::TestPartResult::kSuccess) { continue; }
+            ::testing::internal::AssertHelper(result.type(), result.file_name(), result.line_number(), result.message()) = ::testing::Message();
         }
+    }
+
+    inline std::string FirstFailure_(const ::testing::TestPartResultArray& results) {
+        for (int i = 0; i < results.size(); ++i) {
+            const auto& result = results.GetTestPartResult(i);
+            if (!result.failed()) { continue; }
+            std::ostringstream failure;
+            if (result.file_name() != nullptr) { failure << result.file_name() << ':' << result.line_number() << ": "; }
+            failure << result.summary();
+            return failure.str();
+        }
+        return {};
+    }
+
+    /// A test that failed at least once with retries left
+    struct RetriedTest {
+        /// "Suite.test"
+        std::string name;
+        int attempts = 0;
+        /// Whether an attempt passed, the test is flaky
+        bool passed = false;
     };
 
-    /// Registers a vector of tests from a test suite, can be less or more than overload
-    template<typename TestSuite>
-    size_t InternalRegisterTestsVector(
-        std::vector<TestData<TestSuite>>& testSuiteData,
-        const char* file_name,
-        const int line_number,
-        const char* fixtureName)
-    {
-        // Never occurs with expected usage so safe to assert.
-        CppUnit2Gtest_CHECK(file_name != nullptr);
-        CppUnit2Gtest_CHECK(fixtureName != nullptr);
-        for(auto& testData : testSuiteData)
-        {
-            auto testMethod = testData.testMethod;
-            // Register the test programmatically
-            ::testing::RegisterTest(
-                 fixtureName,              // name of the fixture
-                 testData.testName,        // name of the test
-                 nullptr, nullptr,         // argument details for parametrised tests
-                 file_name, line_number,   // For the log
-                 // Any callable that returns adress of an object inheriting testing::Test 
-                 [testMethod]() -> DynamicTest<TestSuite>* { return new DynamicTest<TestSuite>(testMethod); }
-             );
+    /// The tests retried so far, in the order they ran
+    inline std::vector<RetriedTest>& RetriedTests() {
+        static std::vector<RetriedTest> tests;
+        return tests;
+    }
+
+    /// Writes the retried tests as "test\tattempts\tresult" lines, the result being flaky or failed
+    inline void WriteRetriedTests(std::ostream& out) {
+        out << "test\tattempts\tresult\n";
+        for (const auto& test : RetriedTests()) {
+            out << test.name << '\t' << test.attempts << '\t' << (test.passed ? "flaky" : "failed") << '\n';
         }
-        return testSuiteData.size();
     }
 
-    /// Register required tests from a suite 
-    template<typename TestSuite>
-    size_t InternalRegisterTests(const char* file_name, int line_number, const char* fixtureName )
-    {
-        std::vector<TestData<TestSuite>> tests = TestSuite::GetAllTests_();
+    /// Prints the flaky tests at the end, or writes them to CPPUNIT2GTEST_FLAKY_REPORT
+    struct RetriesListener : ::testing::EmptyTestEventListener {
+        void OnTestProgramEnd(const ::testing::UnitTest&) override {
+            const auto& tests = RetriedTests();
+            if (tests.empty()) { return; }
+            const char* path = std::getenv("CPPUNIT2GTEST_FLAKY_REPORT");
+            if (path != nullptr && *path != '\0') {
+                std::ofstream out(path);
+                WriteRetriedTests(out);
+                return;
+            }
+            size_t flaky = 0;
+            for (const auto& test : tests) { flaky += test.passed ? 1 : 0; }
+            std::cout << "[  FLAKY   ] " << flaky << " of " << tests.size() << " retried tests passed on a later attempt\n";
+            for (const auto& test : tests) {
+                std::cout << "[  FLAKY   ] " << test.name << (test.passed ? " passed on attempt " : " failed all ")
+                          << test.attempts << (test.passed ? "\n" : " attempts\n");
+            }
+        }
+    };
 
-        InternalRegisterTestsVector(tests, file_name, line_number, fixtureName);
-        // return an int so we can call this statically a bit easier
-        return tests.size();
+    inline void RecordAttempts_(const int attempts, const bool passed) {
+        if (attempts < 2) { return; }
+        // gtest owns the listener, the first retried test adds it
+        static const bool installed = []() {
+            ::testing::UnitTest::GetInstance()->listeners().Append(new RetriesListener{});
+            return true;
+        }();
+        static_cast<void>(installed);
+        const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+        RetriedTest test;
+        test.name = testInfo != nullptr ? std::string(testInfo->test_suite_name()) + "." + testInfo->name() : "";
+        test.attempts = attempts;
+        test.passed = passed;
+        RetriedTests().push_back(std::move(test));
     }
+#endif // CppUnit2Gtest_EnableRetries
 
 #undef CppUnit2Gtest_CHECK
 }
@@ -151,9 +4228,10 @@ namespace to { namespace gtest {
 /// Takes a suite name and creates a vector of function pointers to the functions given in the registration
 #define CPPUNIT_TEST_SUITE(SuiteName) \
     using Cpp2GTest_CurrentClass = SuiteName; \
-    using TestDataType = ::CppUnit::to::gtest::TestData<SuiteName>; \
     public: \
-        [[nodiscard]] static auto GetAllTests_() { std::vector<TestDataType> allTestData{}
+        [[nodiscard]] static auto GetAllTests_() { \
+            ::CppUnit::to::gtest::Properties suiteProperties_{}; \
+            std::vector<::CppUnit::to::gtest::TestData<Cpp2GTest_CurrentClass>> allTestData{}
 
 /// Takes a suite name and a base class, adds all the tests from the base class to this suite
 #define CPPUNIT_TEST_SUB_SUITE(SuiteName, BaseClass) \
@@ -173,7 +4251,7 @@ namespace to { namespace gtest {
             auto t = &Cpp2GTest_CurrentClass:: test_name ; \
             (c.*t)(); \
         }; \
-        allTestData.emplace_back(test_pointer, __LINE__, #test_name); \
+        allTestData.emplace_back(test_pointer, __LINE__, #test_name, __FILE__); \
     }()
 
 /// This functionality is deprecated from CppUnit, we recommend changing any usages to
@@ -184,9 +4262,35 @@ namespace to { namespace gtest {
             auto t = &Cpp2GTest_CurrentClass:: test_name ; \
             ASSERT_THROW( (c.*t)() , exception ); \
         }; \
-        allTestData.emplace_back(test_pointer, __LINE__, #test_name ); \
+        allTestData.emplace_back(test_pointer, __LINE__, #test_name, __FILE__ ); \
     }()
 
+/// Adds a test method taking a parameter, called with each case of a container, a braced list
+///  or a source such as MappedParameters. Large sources are registered as chunks of cases
+#define CPPUNIT_TEST_PARAMETERIZED(test_name, ...) \
+    ::CppUnit::to::gtest::AddParameterizedTests_(allTestData, #test_name, __LINE__, __FILE__, \
+        ::CppUnit::to::gtest::ParametersOf_(__VA_ARGS__), \
+        [](Cpp2GTest_CurrentClass& c, const auto& parameter) { c.test_name(parameter); })
+
+#if defined(CppUnit2Gtest_EnableBenchmarks)
+/// Registers a test method as a benchmark that reuses the fixture's setUp and tearDown.
+///  It is registered disabled, run benchmarks with
+///  --gtest_also_run_disabled_tests --gtest_filter='*.DISABLED_BENCHMARK_*'
+#define CPPUNIT_BENCHMARK(test_name) \
+    [&](){ \
+        auto test_pointer = +[](Cpp2GTest_CurrentClass& c) { \
+            auto t = &Cpp2GTest_CurrentClass:: test_name ; \
+            static_cast<void>(::CppUnit::to::gtest::RunBenchmark_( \
+                [&c, t]() { (c.*t)(); }, \
+                [&c]() { c.tearDown(); c.setUp(); })); \
+        }; \
+        allTestData.emplace_back(test_pointer, __LINE__, "DISABLED_BENCHMARK_" #test_name, __FILE__); \
+    }()
+#else
+/// Benchmarks are only registered when CppUnit2Gtest_EnableBenchmarks is defined
+#define CPPUNIT_BENCHMARK(test_name) static_cast<void>(0)
+#endif
+
 #define CPPUNIT_TEST_FAIL(v) static_assert(false, \
     "CPPUNIT_TEST_FAIL was called with " #v ". It is not supported. \n" \
     " It's intetion is to test custom CPPUNIT macros. \n" \
@@ -194,32 +4298,55 @@ namespace to { namespace gtest {
     " Please rewrite the test in GTest"\
 )
 
-// We could add CPPUNIT_TEST_SUITE_ADD_CUSTOM_TESTS with some complicated types
-//  Don't add it for now
-
-// If we want CPPUNIT_TEST_SUITE_PROPERTY we have to call `::testing::Test::RecordProperty`
-//  but we have to do it after SetUpTestSuite and before TearDownTestSuite
-//  the macro is called between CPPUNIT_TEST_SUITE and CPPUNIT_TEST_SUITE_END (needs proof)
-//   so we'd need some state on the class and set it in the `GetAllTests_` function
+/// Calls the suite's static method with a CustomTests to add tests that aren't methods,
+///  i.e. `static void addTests(::CppUnit::to::gtest::CustomTests<MySuite>& tests)`
+#define CPPUNIT_TEST_SUITE_ADD_CUSTOM_TESTS(testAdderMethod) \
+    [&](){ \
+        ::CppUnit::to::gtest::CustomTests<Cpp2GTest_CurrentClass> customTests_{allTestData, __FILE__, __LINE__}; \
+        Cpp2GTest_CurrentClass::testAdderMethod(customTests_); \
+    }()
 
-// Do nothing for now
-#define CPPUNIT_TEST_SUITE_PROPERTY( unused_1, unused_2 ) 
+/// Adds a property to every test in the suite, use "testName.key" to add it to a single test.
+///  Each test records its properties with `::testing::Test::RecordProperty` when it runs
+///  (so they end up in gtest's xml/json output), except the ones the adaptor reads, i.e. "timeout_ms".
+///  Keys gtest uses itself (i.e. "name", "time") are recorded with a "property_" prefix
+#define CPPUNIT_TEST_SUITE_PROPERTY( key, value ) \
+    suiteProperties_.emplace_back(std::string(key), std::string(value))
 
 /// Ends the vector of tests
-#define CPPUNIT_TEST_SUITE_END() return allTestData; } void TestBody() override {}
+#define CPPUNIT_TEST_SUITE_END() \
+    return ::CppUnit::to::gtest::ApplyProperties(std::move(allTestData), suiteProperties_); } \
+    void TestBody() override {}
 
 /// Does the same as CPPUNIT_TEST_SUITE_END but the class remains abstract
-#define CPPUNIT_TEST_SUITE_END_ABSTRACT() return allTestData; }
+#define CPPUNIT_TEST_SUITE_END_ABSTRACT() \
+    return ::CppUnit::to::gtest::ApplyProperties(std::move(allTestData), suiteProperties_); }
 
 #define Cpp2Gtest_CONCAT(a, b) Cpp2Gtest_CONCAT_INNER(a, b)
 #define Cpp2Gtest_CONCAT_INNER(a, b) a ## b
-#define Cpp2Gtest_UNIQUE_NAME(base) Cpp2Gtest_CONCAT(base, __LINE__)
+// Registrations of files merged by a unity build can share a line, __COUNTER__ can't repeat
+#if defined(__COUNTER__)
+#   define Cpp2Gtest_UNIQUE_NAME(base) Cpp2Gtest_CONCAT(base, __COUNTER__)
+#else
+#   define Cpp2Gtest_UNIQUE_NAME(base) Cpp2Gtest_CONCAT(base, __LINE__)
+#endif
 
 #define CPPUNIT_TEST_SUITE_REGISTRATION(Class_name) CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(Class_name, #Class_name)
 
 #define CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(Class_name, suite_additional_name ) namespace{ \
     static const size_t Cpp2Gtest_UNIQUE_NAME(unused_) = \
-    ::CppUnit::to::gtest::InternalRegisterTests<Class_name>(#Class_name, __LINE__, suite_additional_name); \
+    ::CppUnit::to::gtest::InternalRegisterTests<Class_name>(__FILE__, __LINE__, suite_additional_name); \
+}
+
+/// Registers a templated fixture once per type, as the suites "Fixture/Type". Different types
+///  may be registered in different files to spread the cost of instantiating them
+#define CPPUNIT_TYPED_TEST_SUITE_REGISTRATION(Template_name, ...) \
+    CPPUNIT_TYPED_TEST_SUITE_NAMED_REGISTRATION(Template_name, #Template_name, __VA_ARGS__)
+
+#define CPPUNIT_TYPED_TEST_SUITE_NAMED_REGISTRATION(Template_name, suite_name, ...) namespace{ \
+    static const size_t Cpp2Gtest_UNIQUE_NAME(unused_) = \
+    ::CppUnit::to::gtest::InternalRegisterTypedTests<Template_name>(__FILE__, __LINE__, suite_name, \
+        ::CppUnit::to::gtest::TypeList<__VA_ARGS__>{}); \
 }
 
 /// The following two macros are for running the tests under a hierarchy,
@@ -236,24 +4363,6 @@ namespace to { namespace gtest {
 #   define CU_TEST_SUITE_REGISTRATION(tc)   CPPUNIT_TEST_SUITE_REGISTRATION(tc)
 #endif
 
-#if defined(CppUnit2Gtest_AllowAssertsInConstructors)
-
-/// Note: gtest args must be surrounded by brackets: 
-//   CppUnit2Gtest_assertion_wrapper_(TRUE, (true))
-//   CppUnit2Gtest_assertion_wrapper_(TRUE, (true) << "expected true")
-#   define CppUnit2Gtest_assertion_wrapper_(gtest_assertion, args) \
-    EXPECT_ ## gtest_assertion args ; if (::testing::Test::HasFailure()) throw ::CppUnit::to::gtest::ExitingAssertion{} 
-
-#   define CppUnit2Gtest_fail_wrapper_() ADD_FAILURE()
-
-#else // CppUnit2Gtest_AllowAssertsInConstructors
-#   define CppUnit2Gtest_assertion_wrapper_(gtest_assertion, args) \
-    ASSERT_ ## gtest_assertion args 
-
-#   define CppUnit2Gtest_fail_wrapper_() FAIL()
-
-#endif
-
 // For backwards compatibility, not recommended
 #if CPPUNIT_ENABLE_NAKED_ASSERT
 #   undef assert
@@ -265,51 +4374,58 @@ namespace to { namespace gtest {
 
 #define CPPUNIT_TEST_FIXTURE(FixtureClass,testName) TEST_F(FixtureClass, testName)
 
-// Asserting
-#define CPPUNIT_ASSERT(condition)                                    CppUnit2Gtest_assertion_wrapper_(TRUE, (condition))
-#define CPPUNIT_ASSERT_MESSAGE(message, condition)                   CppUnit2Gtest_assertion_wrapper_(TRUE, (condition) << message)
-#define CPPUNIT_ASSERT_EQUAL(a, b)                                   CppUnit2Gtest_assertion_wrapper_(EQ, (a, b))
-#define CPPUNIT_ASSERT_EQUAL_MESSAGE(msg, a, b)                      CppUnit2Gtest_assertion_wrapper_(EQ, (a, b) << msg)
-#define CPPUNIT_ASSERT_NO_THROW(expression)                          CppUnit2Gtest_assertion_wrapper_(NO_THROW,(expression))
-#define CPPUNIT_ASSERT_NO_THROW_MESSAGE(msg, expression)             CppUnit2Gtest_assertion_wrapper_(NO_THROW,(expression) << message)
-#define CPPUNIT_ASSERT_THROW(expression, expected)                   CppUnit2Gtest_assertion_wrapper_(THROW, (expression, expected))
-#define CPPUNIT_ASSERT_THROW_MESSAGE(message, expression, expected)  CppUnit2Gtest_assertion_wrapper_(THROW,(expression, expected) << message)
-#define CPPUNIT_ASSERT_DOUBLES_EQUAL(a,b, t)                         CppUnit2Gtest_assertion_wrapper_(NEAR, (a, b, t))
-#define CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(msg, a, b, t)           CppUnit2Gtest_assertion_wrapper_(NEAR, (a, b, t) << msg)
-#define CPPUNIT_FAIL(message)                                        CppUnit2Gtest_fail_wrapper_() << message
-#define CPPUNIT_ASSERT_ASSERTION_PASS(e)                             CppUnit2Gtest_assertion_wrapper_(NO_THROW, (e))
-#define CPPUNIT_ASSERT_ASSERTION_PASS_MESSAGE(msg, e)                CppUnit2Gtest_assertion_wrapper_(NO_THROW, (e) << msg)
-#define CPPUNIT_ASSERT_LESS(expected, actual)                        CppUnit2Gtest_assertion_wrapper_(LT, (actual, expected))
-#define CPPUNIT_ASSERT_LESSEQUAL(expected, actual)                   CppUnit2Gtest_assertion_wrapper_(LE, (actual, expected))
-#define CPPUNIT_ASSERT_GREATER(expected, actual)                     CppUnit2Gtest_assertion_wrapper_(GT, (actual, expected))
-#define CPPUNIT_ASSERT_GREATEREQUAL(expected, actual)                CppUnit2Gtest_assertion_wrapper_(GE, (actual, expected))
-
-// These aren't in CppUnit but we can be nicer to the user
-#define CPPUNIT_ASSERT_LESS_MESSAGE(msg, expected, actual)           CppUnit2Gtest_assertion_wrapper_(LT, (actual, expected) << msg)
-#define CPPUNIT_ASSERT_GREATER_MESSAGE(msg, expected, actual)        CppUnit2Gtest_assertion_wrapper_(GT, (actual, expected) << msg)
-#define CPPUNIT_ASSERT_LESSEQUAL_MESSAGE(msg, expected, actual)      CppUnit2Gtest_assertion_wrapper_(LE, (actual, expected) << msg)
-#define CPPUNIT_ASSERT_GREATEREQUAL_MESSAGE(msg, expected, actual)   CppUnit2Gtest_assertion_wrapper_(GE, (actual, expected) << msg)
+#if defined(CppUnit2Gtest_EnablePerformanceAssertions)
+/// Repeats the expression and fails when its median time is clearly over budget_ns
+#   define CPPUNIT_ASSERT_FASTER_THAN(budget_ns, expression) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT3, (::CppUnit::to::gtest::FasterThan_, budget_ns, #expression, [&]() { expression; }))
+#   define CPPUNIT_ASSERT_FASTER_THAN_MESSAGE(msg, budget_ns, expression) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT3, (::CppUnit::to::gtest::FasterThan_, budget_ns, #expression, [&]() { expression; }) << msg)
+/// Repeats the expression and fails when it usually allocates more than n times (needs CppUnit2Gtest_CountAllocations)
+#   define CPPUNIT_ASSERT_ALLOCATES_AT_MOST(n, expression) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT3, (::CppUnit::to::gtest::AllocatesAtMost_, n, #expression, [&]() { expression; }))
+#   define CPPUNIT_ASSERT_ALLOCATES_AT_MOST_MESSAGE(msg, n, expression) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT3, (::CppUnit::to::gtest::AllocatesAtMost_, n, #expression, [&]() { expression; }) << msg)
+#endif
 
-#define CppUnit2Gtest_FailCompilation_NotSupported_ static_assert(false, \
-    "This CppUnit macro is not supported. Please rewrite this test in GTest or with implmented macros")
+#if defined(CppUnit2Gtest_EnableGoldenFiles)
+/// Compares two files byte for byte and shows the first difference
+#   define CPPUNIT_ASSERT_FILES_EQUAL(actual_path, expected_path) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT2, (::CppUnit::to::gtest::FilesEqual_, actual_path, expected_path))
+#   define CPPUNIT_ASSERT_FILES_EQUAL_MESSAGE(msg, actual_path, expected_path) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT2, (::CppUnit::to::gtest::FilesEqual_, actual_path, expected_path) << msg)
+/// Like CPPUNIT_ASSERT_FILES_EQUAL, or rewrites golden_path when CPPUNIT2GTEST_UPDATE_GOLDEN is set
+#   define CPPUNIT_ASSERT_MATCHES_GOLDEN(actual_path, golden_path) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT2, (::CppUnit::to::gtest::MatchesGolden_, actual_path, golden_path))
+#   define CPPUNIT_ASSERT_MATCHES_GOLDEN_MESSAGE(msg, actual_path, golden_path) \
+    CppUnit2Gtest_assertion_wrapper_(PRED_FORMAT2, (::CppUnit::to::gtest::MatchesGolden_, actual_path, golden_path) << msg)
+#endif
 
 // Some macros are intentionally not added
-//  Most are to allow users to define them themselves if they wish
-//      CPPUNIT_TEST_SUITE_PROPERTY
-//  Some however should really be re-written
+//  Some should really be re-written
 // These include:
 #define CPPUNIT_TEST_SUITE_ADD_TEST(t)              CppUnit2Gtest_FailCompilation_NotSupported_
-#define CPPUNIT_ASSERT_ASSERTION_FAIL(t)            CppUnit2Gtest_FailCompilation_NotSupported_
-#define CPPUNIT_EXTRACT_EXCEPTION_TYPE_(t)          CppUnit2Gtest_FailCompilation_NotSupported_
-#define CPPUNIT_ASSERT_ASSERTION_FAIL_MESSAGE(t)    CppUnit2Gtest_FailCompilation_NotSupported_
-#define CppUnit2Gtest_BadCast_ static_assert(false, "This did a C style cast and is unlikely to be what you wanted")
-#define CPPUNIT_STATIC_CAST(a, b)   CppUnit2Gtest_BadCast_
-#define CPPUNIT_CONST_CAST(a,b)     CppUnit2Gtest_BadCast_
+
+#if defined(_WIN32)
+#   define CppUnit2Gtest_PluginExport_ __declspec(dllexport)
+#else
+#   define CppUnit2Gtest_PluginExport_ __attribute__((visibility("default")))
+#endif
+/// Marks a shared object as a test plugin, use it in exactly one of its files.
+///  Its suites register when a runner (CPPUNIT_PLUGIN_RUNNER_MAIN) loads it
+#define CPPUNIT_PLUGIN_IMPLEMENT() \
+    extern "C" CppUnit2Gtest_PluginExport_ const void* CppUnit2Gtest_PluginUnitTest() { \
+        return ::testing::UnitTest::GetInstance(); \
+    }
+
+#if defined(CppUnit2Gtest_EnablePlugins)
+/// The main of a runner that loads the plugins given on its command line
+#   define CPPUNIT_PLUGIN_RUNNER_MAIN() \
+    int main(int argc, char** argv) { return ::CppUnit::to::gtest::RunTestPlugins(argc, argv); }
+#endif
 
 // Macros that (now) do nothing have been implemented as such
-//  These were for exporting plugins (not adding a main).
+//  CppUnit needed this for plugins on some platforms, ours don't have a main
 #define CPPUNIT_PLUGIN_IMPLEMENT_MAIN()
-#define CPPUNIT_PLUGIN_IMPLEMENT()
 #define CPPUNIT_WRAP_COLUMN 1
 
 #if defined(Cpp2Unit2Gtest_EnableMainHelperClasses)
@@ -433,6 +4549,11 @@ namespace to { namespace gtest {
         }
     };
 
+#   if defined(CppUnit2Gtest_EnableRegistrationStats)
+    /// What registering a suite of the tree cost, empty if InternalRegisterTests didn't register it
+    [[nodiscard]] inline RegistrationStats RegistrationOf(const TestAdaptorSuite& suite) { return FindRegistrationStats(suite.getName()); }
+#   endif
+
 }} // namespace to::gtest
 
 struct TestFactoryRegistry {
@@ -445,6 +4566,7 @@ struct TestFactoryRegistry {
     }
 
     Test* makeTest() {
+        for (const auto hook : to::gtest::MainHooks_::Instance().beforeListing) { hook(); }
         static to::gtest::TestAdaptorRoot root;
         return &root;
     }
@@ -507,6 +4629,11 @@ struct TextTestRunner {
         std::string fake_exe_name = "executable_name";
         char* argv_data[] = { fake_exe_name.data(), filter.data() };
         testing::InitGoogleTest(&argc, argv_data);
+        // Deferred prioritized suites were registered by InitGoogleTest
+        for (const auto runner : to::gtest::MainHooks_::Instance().runners) {
+            bool passed = false;
+            if (runner(passed)) { return passed; }
+        }
         return 0 == RUN_ALL_TESTS();
     }
     // Required by
@@ -527,4 +4654,23 @@ namespace TextUi {
 
 #endif // Cpp2Unit2Gtest_EnableMainHelperClasses
 
+#if (defined(CppUnit2Gtest_EnablePerformanceAssertions) || defined(CppUnit2Gtest_EnableRegistrationStats)) \
+    && defined(CppUnit2Gtest_CountAllocations)
+// Replaces the global allocation functions to count allocations, define it in one translation unit only.
+//  The other forms of new and delete (array, nothrow, sized) call these ones by default
+void* operator new(std::size_t size) {
+    ++::CppUnit::to::gtest::AllocationCount_();
+    // Registrations in other translation units can run before the flag below is initialized
+    ::CppUnit::to::gtest::AllocationCounterInstalled_() = true;
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) { return memory; }
+    throw std::bad_alloc{};
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace CppUnit { namespace to { namespace gtest {
+    const bool allocationCounterInstalled_ = (AllocationCounterInstalled_() = true);
+}}}
+#endif
+
 #endif // C++11 style header guard CPPUNIT_TO_GTEST_HEADER_
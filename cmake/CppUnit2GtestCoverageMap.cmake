@@ -0,0 +1,67 @@
+# Turns the per test profiles written with CPPUNIT2GTEST_PROFILE_DIR into the coverage map read from
+#  CPPUNIT2GTEST_COVERAGE_MAP (lines of "Suite.test<tab>file<tab>file...")
+#
+# cmake -DPROFILE_DIR=<dir> -DBINARY=<test executable> -DOUTPUT=<map file>
+#       [-DLLVM_PROFDATA=<llvm-profdata>] [-DLLVM_COV=<llvm-cov>] -P CppUnit2GtestCoverageMap.cmake
+cmake_minimum_required(VERSION 3.2...3.31)
+
+foreach(required PROFILE_DIR BINARY OUTPUT)
+    if(NOT DEFINED ${required})
+        message(FATAL_ERROR "${required} must be set")
+    endif()
+endforeach()
+
+if(NOT LLVM_PROFDATA)
+    find_program(LLVM_PROFDATA llvm-profdata)
+endif()
+if(NOT LLVM_COV)
+    find_program(LLVM_COV llvm-cov)
+endif()
+if(NOT LLVM_PROFDATA OR NOT LLVM_COV)
+    message(FATAL_ERROR "llvm-profdata and llvm-cov are needed (set LLVM_PROFDATA and LLVM_COV)")
+endif()
+
+file(GLOB profiles "${PROFILE_DIR}/*.profraw")
+set(map "")
+foreach(profile IN LISTS profiles)
+    get_filename_component(test "${profile}" NAME)
+    string(REGEX REPLACE "\\.profraw$" "" test "${test}")
+    if(test STREQUAL "after_tests")
+        continue()
+    endif()
+
+    set(merged "${PROFILE_DIR}/${test}.profdata")
+    execute_process(
+        COMMAND "${LLVM_PROFDATA}" merge -sparse "${profile}" -o "${merged}"
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "llvm-profdata failed for ${profile}")
+    endif()
+    execute_process(
+        COMMAND "${LLVM_COV}" export -format=lcov -skip-functions "-instr-profile=${merged}" "${BINARY}"
+        OUTPUT_VARIABLE lcov
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "llvm-cov failed for ${profile}")
+    endif()
+
+    # Every source file with a line hit (LH) above zero
+    set(line "${test}")
+    set(source "")
+    string(REPLACE ";" "\;" lcov "${lcov}")
+    string(REPLACE "\n" ";" lcov "${lcov}")
+    foreach(record IN LISTS lcov)
+        if(record MATCHES "^SF:(.*)$")
+            set(source "${CMAKE_MATCH_1}")
+        elseif(record MATCHES "^LH:([0-9]+)$" AND CMAKE_MATCH_1 GREATER 0)
+            set(line "${line}\t${source}")
+        endif()
+    endforeach()
+    string(APPEND map "${line}\n")
+endforeach()
+
+file(WRITE "${OUTPUT}" "${map}")
+list(LENGTH profiles count)
+message(STATUS "Wrote the coverage of ${count} profiles to ${OUTPUT}")
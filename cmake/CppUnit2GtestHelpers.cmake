@@ -0,0 +1,222 @@
+# Helpers for projects using CppUnit2Gtest, included by the package config
+#
+# cppunit2gtest_unity_batches(<target> [BATCHES <count>] [BATCH_SIZE <sources>] [SOURCES <source>...])
+#   Builds the target's test sources (all of its C++ sources by default) as unity batches of about
+#   the same size, so one large file doesn't make a single batch the slowest to compile.
+#   Without BATCHES there is a batch for every BATCH_SIZE (default 8) sources.
+#   Sources are spread largest first onto the smallest batch, needs CMake 3.18 for UNITY_BUILD_MODE GROUP
+#   and falls back to CMake's own batching before that.
+#
+# cppunit2gtest_add_plugin_runner(<name>)
+#   An executable that loads test plugins (files or directories given as arguments) and runs their tests.
+#   It links all of gtest and exports it for the plugins, needs CMake 3.24.
+#   On linux, running it with CPPUNIT2GTEST_WATCH=1 reruns each plugin when it is rebuilt
+#
+# cppunit2gtest_add_test_plugin(<name> <runner> <source>...)
+#   A shared object the runner can load, one of its sources must use CPPUNIT_PLUGIN_IMPLEMENT().
+#   Changing a test only relinks its plugin
+#
+# cppunit2gtest_manifest_tests(<target> [TEST_PREFIX <prefix>] [WORKING_DIRECTORY <dir>]
+#                              [SOURCES <source>...] [EXTRA_ARGS <arg>...] [PROPERTIES <name> <value>...])
+#   Adds a CTest test for each test the target's sources (all of its sources by default) register,
+#   read from the CPPUNIT_TEST_SUITE, CPPUNIT_TEST and registration macros at build time, so the
+#   binary is never run to list them like gtest_discover_tests does. The manifest is written
+#   next to the target as <target>_manifest.txt, sources declaring suites in headers should list them
+#
+# cppunit2gtest_add_tests(<target> BATCH_SIZE <tests> | PER_SUITE | BY_DURATION <seconds> [<cppunit2gtest_manifest_tests options>])
+#   Like cppunit2gtest_manifest_tests but each CTest test runs a batch of tests through a gtest filter,
+#   fewer processes and registrations for less parallelism. Every batch writes the result of each of
+#   its tests to <target>_results/<batch>.xml, CTest only has a result per batch (the failed tests are
+#   in its output and that file). BY_DURATION packs batches of about the given seconds
+#   from the times in those results (tests that haven't run count as 100ms), so it settles after a run
+set(CppUnit2Gtest_HELPERS_DIR_ "${CMAKE_CURRENT_LIST_DIR}")
+
+function(cppunit2gtest_unity_batches target)
+    cmake_parse_arguments(PARSE_ARGV 1 arg "" "BATCHES;BATCH_SIZE" "SOURCES")
+    if(NOT arg_BATCH_SIZE)
+        set(arg_BATCH_SIZE 8)
+    endif()
+    if(NOT arg_SOURCES)
+        get_target_property(arg_SOURCES ${target} SOURCES)
+    endif()
+    get_target_property(sourceDir ${target} SOURCE_DIR)
+
+    # Only C++ translation units can be merged
+    set(sources "")
+    foreach(source IN LISTS arg_SOURCES)
+        if(source MATCHES "\\.(cpp|cc|cxx|c\\+\\+)$")
+            list(APPEND sources "${source}")
+        endif()
+    endforeach()
+    list(LENGTH sources count)
+    if(count EQUAL 0)
+        return()
+    endif()
+
+    set_target_properties(${target} PROPERTIES UNITY_BUILD ON)
+    if(CMAKE_VERSION VERSION_LESS 3.18)
+        set_target_properties(${target} PROPERTIES UNITY_BUILD_BATCH_SIZE ${arg_BATCH_SIZE})
+        return()
+    endif()
+
+    if(arg_BATCHES)
+        set(batches ${arg_BATCHES})
+    else()
+        math(EXPR batches "(${count} + ${arg_BATCH_SIZE} - 1) / ${arg_BATCH_SIZE}")
+    endif()
+    if(batches GREATER count)
+        set(batches ${count})
+    endif()
+
+    # Sort by size, zero padded so the string sort orders numbers
+    set(sized "")
+    foreach(source IN LISTS sources)
+        set(path "${source}")
+        if(NOT IS_ABSOLUTE "${path}")
+            set(path "${sourceDir}/${path}")
+        endif()
+        set(size 0)
+        if(EXISTS "${path}")
+            file(SIZE "${path}" size)
+        endif()
+        string(LENGTH "${size}" digits)
+        math(EXPR padding "12 - ${digits}")
+        string(REPEAT "0" ${padding} zeros)
+        list(APPEND sized "${zeros}${size}|${source}")
+    endforeach()
+    list(SORT sized ORDER DESCENDING)
+
+    math(EXPR lastBatch "${batches} - 1")
+    foreach(batch RANGE ${lastBatch})
+        set(total_${batch} 0)
+    endforeach()
+    foreach(entry IN LISTS sized)
+        string(REGEX MATCH "^([0-9]+)\\|(.*)$" unused "${entry}")
+        math(EXPR size "${CMAKE_MATCH_1}")
+        set(source "${CMAKE_MATCH_2}")
+        set(smallest 0)
+        foreach(batch RANGE ${lastBatch})
+            if(total_${batch} LESS total_${smallest})
+                set(smallest ${batch})
+            endif()
+        endforeach()
+        math(EXPR total_${smallest} "${total_${smallest}} + ${size}")
+        set_source_files_properties("${source}" TARGET_DIRECTORY ${target}
+            PROPERTIES UNITY_GROUP "cppunit2gtest_${target}_${smallest}")
+    endforeach()
+    set_target_properties(${target} PROPERTIES UNITY_BUILD_MODE GROUP)
+endfunction()
+
+# The gtest library target itself (found or fetched), not an interface wrapping it
+function(cppunit2gtest_gtest_library_ result)
+    if(TARGET GTest::gtest)
+        set(${result} GTest::gtest PARENT_SCOPE)
+    elseif(TARGET gtest)
+        set(${result} gtest PARENT_SCOPE)
+    else()
+        set(${result} GTest::GTest PARENT_SCOPE)
+    endif()
+endfunction()
+
+function(cppunit2gtest_add_plugin_runner name)
+    if(CMAKE_VERSION VERSION_LESS 3.24)
+        message(FATAL_ERROR "cppunit2gtest_add_plugin_runner needs CMake 3.24 or newer")
+    endif()
+    set(source "${CMAKE_CURRENT_BINARY_DIR}/${name}_main.cpp")
+    file(WRITE "${source}"
+        "#define CppUnit2Gtest_EnablePlugins\n"
+        "#if defined(__linux__)\n"
+        "#   define CppUnit2Gtest_EnableWatch\n"
+        "#endif\n"
+        "#include <cppunit/extensions/HelperMacros.h>\n"
+        "CPPUNIT_PLUGIN_RUNNER_MAIN()\n")
+    add_executable(${name} "${source}")
+    set_target_properties(${name} PROPERTIES ENABLE_EXPORTS ON)
+    # Plugins use the runner's gtest, even the parts the runner itself doesn't call
+    cppunit2gtest_gtest_library_(gtest)
+    target_link_libraries(${name} PRIVATE "$<LINK_LIBRARY:WHOLE_ARCHIVE,${gtest}>" ${CMAKE_DL_LIBS})
+    if(TARGET CppUnit2Gtest::CppUnit2Gtest)
+        target_link_libraries(${name} PRIVATE CppUnit2Gtest::CppUnit2Gtest)
+    endif()
+endfunction()
+
+function(cppunit2gtest_add_test_plugin name runner)
+    add_library(${name} MODULE ${ARGN})
+    # Resolves gtest from the runner when loaded rather than carrying a second copy
+    target_link_libraries(${name} PRIVATE ${runner})
+    cppunit2gtest_gtest_library_(gtest)
+    target_include_directories(${name} PRIVATE $<TARGET_PROPERTY:${gtest},INTERFACE_INCLUDE_DIRECTORIES>)
+    if(TARGET CppUnit2Gtest::CppUnit2Gtest)
+        target_include_directories(${name} PRIVATE
+            $<TARGET_PROPERTY:CppUnit2Gtest::CppUnit2Gtest,INTERFACE_INCLUDE_DIRECTORIES>)
+    endif()
+endfunction()
+
+function(cppunit2gtest_manifest_tests target)
+    cppunit2gtest_manifest_(${target} "" "" ${ARGN})
+endfunction()
+
+function(cppunit2gtest_add_tests target)
+    cmake_parse_arguments(PARSE_ARGV 1 arg "PER_SUITE" "BATCH_SIZE;BY_DURATION" "")
+    if(arg_PER_SUITE)
+        cppunit2gtest_manifest_(${target} PER_SUITE "" ${arg_UNPARSED_ARGUMENTS})
+    elseif(arg_BY_DURATION)
+        cppunit2gtest_manifest_(${target} BY_DURATION ${arg_BY_DURATION} ${arg_UNPARSED_ARGUMENTS})
+    elseif(arg_BATCH_SIZE)
+        cppunit2gtest_manifest_(${target} BATCH_SIZE ${arg_BATCH_SIZE} ${arg_UNPARSED_ARGUMENTS})
+    else()
+        message(FATAL_ERROR "cppunit2gtest_add_tests needs BATCH_SIZE <tests>, PER_SUITE or BY_DURATION <seconds>")
+    endif()
+endfunction()
+
+# Lists the target's tests when building, CTest adds them (in batches when a mode is given) when it runs
+function(cppunit2gtest_manifest_ target mode modeValue)
+    cmake_parse_arguments(PARSE_ARGV 3 arg "" "TEST_PREFIX;WORKING_DIRECTORY" "SOURCES;EXTRA_ARGS;PROPERTIES")
+    if(NOT arg_SOURCES)
+        get_target_property(arg_SOURCES ${target} SOURCES)
+    endif()
+    get_target_property(sourceDir ${target} SOURCE_DIR)
+    set(sources "")
+    foreach(source IN LISTS arg_SOURCES)
+        if(NOT IS_ABSOLUTE "${source}")
+            set(source "${sourceDir}/${source}")
+        endif()
+        list(APPEND sources "${source}")
+    endforeach()
+
+    set(base "${CMAKE_CURRENT_BINARY_DIR}/${target}")
+    set(script "${CppUnit2Gtest_HELPERS_DIR_}/CppUnit2GtestManifest.cmake")
+    # Lists don't survive a custom command's arguments, the scripts read them from here
+    file(WRITE "${base}_manifest_config.cmake"
+        "set(TARGET [==[${target}]==])\n"
+        "set(SOURCES [==[${sources}]==])\n"
+        "set(MANIFEST [==[${base}_manifest.txt]==])\n"
+        "set(EXECUTABLE_FILE [==[${base}_executable.cmake]==])\n"
+        "set(TEST_PREFIX [==[${arg_TEST_PREFIX}]==])\n"
+        "set(EXTRA_ARGS [==[${arg_EXTRA_ARGS}]==])\n"
+        "set(WORKING_DIRECTORY [==[${arg_WORKING_DIRECTORY}]==])\n"
+        "set(PROPERTIES [==[${arg_PROPERTIES}]==])\n"
+        "set(MODE [==[${mode}]==])\n"
+        "set(MODE_VALUE [==[${modeValue}]==])\n"
+        "set(RESULTS_DIR [==[${base}_results]==])\n")
+
+    add_custom_command(
+        OUTPUT "${base}_manifest.txt" "${base}_executable.cmake"
+        COMMAND ${CMAKE_COMMAND} "-DCONFIG=${base}_manifest_config.cmake" "-DEXECUTABLE=$<TARGET_FILE:${target}>"
+            -P "${script}"
+        DEPENDS ${sources} "${script}" "${base}_manifest_config.cmake"
+        COMMENT "Listing the tests of ${target}"
+        VERBATIM)
+    # Only reads the sources, the executable's path makes it build after the target
+    add_custom_target(${target}_manifest ALL DEPENDS "${base}_manifest.txt" "${base}_executable.cmake")
+
+    # CTest adds the tests from the manifest, like gtest_discover_tests' include file
+    file(WRITE "${base}_include.cmake"
+        "if(EXISTS [==[${base}_executable.cmake]==])\n"
+        "    include([==[${CppUnit2Gtest_HELPERS_DIR_}/CppUnit2GtestManifestTests.cmake]==])\n"
+        "    cppunit2gtest_add_manifest_tests_([==[${base}_manifest_config.cmake]==] [==[${base}_executable.cmake]==])\n"
+        "else()\n"
+        "    add_test([==[${target}_NOT_BUILT]==] [==[${target}_NOT_BUILT]==])\n"
+        "endif()\n")
+    set_property(DIRECTORY APPEND PROPERTY TEST_INCLUDE_FILES "${base}_include.cmake")
+endfunction()
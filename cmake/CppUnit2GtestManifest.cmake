@@ -0,0 +1,230 @@
+# Writes the manifest of the tests a CppUnit2Gtest target registers by reading its sources, so CTest can
+#  add them without running the binary (lines of "name<tab>gtest filter<tab>file<tab>line").
+#  Run at build time for cppunit2gtest_manifest_tests and cppunit2gtest_add_tests,
+#  CppUnit2GtestManifestTests.cmake turns the manifest into tests when CTest runs
+#
+# cmake -DCONFIG=<settings written by cppunit2gtest_manifest_tests> -DEXECUTABLE=<test executable> -P CppUnit2GtestManifest.cmake
+#
+# Tests named at run time get one entry for all of them:
+#  CPPUNIT_TEST_PARAMETERIZED "Suite.method/*", CPPUNIT_TYPED_TEST_SUITE_REGISTRATION "Template/*"
+#  and CPPUNIT_TEST_SUITE_ADD_CUSTOM_TESTS "Suite/custom" (the suite without its named tests)
+cmake_minimum_required(VERSION 3.2...3.31)
+
+foreach(required CONFIG EXECUTABLE)
+    if(NOT DEFINED ${required})
+        message(FATAL_ERROR "${required} must be set")
+    endif()
+endforeach()
+# SOURCES, MANIFEST and EXECUTABLE_FILE
+include("${CONFIG}")
+
+set(identifier "[A-Za-z_][A-Za-z0-9_]*")
+set(open "[ \t]*\\([ \t]*")
+
+# "ns::Fixture<Type>" is declared as "Fixture"
+function(cppunit2gtest_class_name_ result name)
+    string(REGEX REPLACE "<.*$" "" name "${name}")
+    string(REGEX REPLACE "^.*::" "" name "${name}")
+    string(STRIP "${name}" name)
+    set(${result} "${name}" PARENT_SCOPE)
+endfunction()
+
+set(registrations "")
+set(fileIndex 0)
+foreach(source IN LISTS SOURCES)
+    if(NOT EXISTS "${source}")
+        continue()
+    endif()
+    math(EXPR fileIndex "${fileIndex} + 1")
+    set(file_${fileIndex} "${source}")
+    file(READ "${source}" content)
+    # Keeps CMake's list handling away from the code
+    string(REPLACE ";" " " content "${content}")
+    string(REPLACE "[" " " content "${content}")
+    string(REPLACE "]" " " content "${content}")
+    string(REPLACE "\\\n" " CppUnit2Gtest_continued_\n" content "${content}")
+    string(REPLACE "\\" " " content "${content}")
+    string(REPLACE "\n" ";" content "${content}")
+
+    set(lineNumber 0)
+    set(inComment OFF)
+    set(inDefine OFF)
+    set(suite "")
+    foreach(line IN LISTS content)
+        math(EXPR lineNumber "${lineNumber} + 1")
+        # Macros using the test macros aren't tests
+        if(inDefine OR line MATCHES "^[ \t]*#[ \t]*define")
+            if(line MATCHES "CppUnit2Gtest_continued_$")
+                set(inDefine ON)
+            else()
+                set(inDefine OFF)
+            endif()
+            continue()
+        endif()
+        # Drop comments, a commented out test isn't registered
+        if(inComment)
+            string(FIND "${line}" "*/" end)
+            if(end EQUAL -1)
+                continue()
+            endif()
+            math(EXPR end "${end} + 2")
+            string(SUBSTRING "${line}" ${end} -1 line)
+            set(inComment OFF)
+        endif()
+        string(REGEX REPLACE "/\\*([^*]|\\*+[^*/])*\\*+/" " " line "${line}")
+        string(REGEX REPLACE "//.*$" "" line "${line}")
+        string(FIND "${line}" "/*" start)
+        if(NOT start EQUAL -1)
+            string(SUBSTRING "${line}" 0 ${start} line)
+            set(inComment ON)
+        endif()
+        if(NOT line MATCHES "TEST")
+            continue()
+        endif()
+
+        if(line MATCHES "CPPUNIT_TEST_SUB_SUITE${open}(${identifier})[ \t]*,[ \t]*([^)]+)\\)")
+            set(suite "${fileIndex}_${CMAKE_MATCH_1}")
+            cppunit2gtest_class_name_(base "${CMAKE_MATCH_2}")
+            set(${suite}_base "${base}")
+            set(${suite}_tests "")
+            list(APPEND suites_${CMAKE_MATCH_1} "${suite}")
+        elseif(line MATCHES "CPPUNIT_TEST_SUITE${open}(${identifier})")
+            set(suite "${fileIndex}_${CMAKE_MATCH_1}")
+            set(${suite}_base "")
+            set(${suite}_tests "")
+            list(APPEND suites_${CMAKE_MATCH_1} "${suite}")
+        endif()
+        if(suite)
+            string(REGEX MATCHALL "CPPUNIT_TEST(_EXCEPTION|_PARAMETERIZED)?${open}${identifier}" tests "${line}")
+            foreach(test IN LISTS tests)
+                string(REGEX MATCH "(${identifier})$" name "${test}")
+                if(test MATCHES "^CPPUNIT_TEST_PARAMETERIZED")
+                    set(name "${name}/*")
+                endif()
+                list(APPEND ${suite}_tests "${name}|${lineNumber}")
+            endforeach()
+            if(line MATCHES "CPPUNIT_TEST_SUITE_ADD_CUSTOM_TESTS${open}")
+                set(${suite}_custom "${lineNumber}")
+            endif()
+            if(line MATCHES "CPPUNIT_TEST_SUITE_END${open}\\)")
+                set(suite "")
+            elseif(line MATCHES "CPPUNIT_TEST_SUITE_END_ABSTRACT${open}\\)")
+                set(suite "")
+            endif()
+        endif()
+
+        # Several registrations can share a line after a unity build
+        string(REGEX MATCHALL "CPPUNIT_TEST_SUITE_REGISTRATION${open}[^)]+\\)" found "${line}")
+        foreach(registration IN LISTS found)
+            string(REGEX REPLACE "^CPPUNIT_TEST_SUITE_REGISTRATION${open}([^)]+)\\)$" "\\1" class "${registration}")
+            string(STRIP "${class}" class)
+            cppunit2gtest_class_name_(className "${class}")
+            list(APPEND registrations "suite|${class}|${className}|${fileIndex}|${lineNumber}")
+        endforeach()
+        string(REGEX MATCHALL "CPPUNIT_TEST_SUITE_NAMED_REGISTRATION${open}[^\"]+\"[^\"]*\"" found "${line}")
+        foreach(registration IN LISTS found)
+            string(REGEX MATCH "${open}([^,\"]+)," unused "${registration}")
+            cppunit2gtest_class_name_(className "${CMAKE_MATCH_1}")
+            string(REGEX MATCH "\"([^\"]*)\"$" unused "${registration}")
+            list(APPEND registrations "suite|${CMAKE_MATCH_1}|${className}|${fileIndex}|${lineNumber}")
+        endforeach()
+        string(REGEX MATCHALL "CPPUNIT_TYPED_TEST_SUITE_(NAMED_)?REGISTRATION${open}[A-Za-z0-9_:]+[ \t]*,[ \t]*(\"[^\"]*\")?" found "${line}")
+        foreach(registration IN LISTS found)
+            if(registration MATCHES "\"([^\"]*)\"$")
+                set(name "${CMAKE_MATCH_1}")
+            else()
+                string(REGEX MATCH "${open}([A-Za-z0-9_:]+)" name "${registration}")
+                set(name "${CMAKE_MATCH_1}")
+            endif()
+            list(APPEND registrations "typed|${name}|${name}|${fileIndex}|${lineNumber}")
+        endforeach()
+        string(REGEX MATCHALL "(^|[^A-Za-z0-9_])(CPPUNIT_TEST_FIXTURE|TEST_F|TEST)${open}${identifier}[ \t]*,[ \t]*${identifier}" found "${line}")
+        foreach(test IN LISTS found)
+            string(REGEX MATCH "(${identifier})[ \t]*,[ \t]*(${identifier})$" unused "${test}")
+            list(APPEND registrations "test|${CMAKE_MATCH_1}.${CMAKE_MATCH_2}|${CMAKE_MATCH_1}|${fileIndex}|${lineNumber}")
+        endforeach()
+    endforeach()
+endforeach()
+
+# A suite declared in the registering file, or else anywhere in the sources
+function(cppunit2gtest_find_suite_ result className fileIndex)
+    set(found "")
+    foreach(suite IN LISTS suites_${className})
+        if(suite STREQUAL "${fileIndex}_${className}")
+            set(found "${suite}")
+            break()
+        elseif(NOT found)
+            set(found "${suite}")
+        endif()
+    endforeach()
+    set(${result} "${found}" PARENT_SCOPE)
+endfunction()
+
+# "name|line" of a suite's tests, a sub suite's base tests come first
+function(cppunit2gtest_suite_tests_ result suite depth)
+    set(tests "")
+    if(${suite}_base AND depth LESS 16)
+        string(REGEX MATCH "^[0-9]+" fileIndex "${suite}")
+        cppunit2gtest_find_suite_(base "${${suite}_base}" ${fileIndex})
+        if(base)
+            math(EXPR depth "${depth} + 1")
+            cppunit2gtest_suite_tests_(tests "${base}" ${depth})
+        endif()
+    endif()
+    list(APPEND tests ${${suite}_tests})
+    set(${result} "${tests}" PARENT_SCOPE)
+endfunction()
+
+set(manifest "")
+set(names "")
+macro(cppunit2gtest_add_entry_ name filter file line)
+    list(FIND names "${name}" seen)
+    if(seen EQUAL -1 AND NOT "${name}" MATCHES "\\.DISABLED_")
+        list(APPEND names "${name}")
+        string(APPEND manifest "${name}\t${filter}\t${file}\t${line}\n")
+    endif()
+endmacro()
+
+foreach(registration IN LISTS registrations)
+    string(REPLACE "|" ";" fields "${registration}")
+    list(GET fields 0 kind)
+    list(GET fields 1 name)
+    list(GET fields 2 className)
+    list(GET fields 3 fileIndex)
+    list(GET fields 4 line)
+    set(file "${file_${fileIndex}}")
+    if(kind STREQUAL "test")
+        cppunit2gtest_add_entry_("${name}" "${name}" "${file}" ${line})
+    elseif(kind STREQUAL "typed")
+        cppunit2gtest_add_entry_("${name}/*" "${name}/*.*" "${file}" ${line})
+    else()
+        cppunit2gtest_find_suite_(suite "${className}" ${fileIndex})
+        if(NOT suite)
+            message(WARNING "${file}:${line}: the suite ${className} registered as ${name} is not in the sources")
+            continue()
+        endif()
+        string(REGEX MATCH "^[0-9]+" suiteFile "${suite}")
+        cppunit2gtest_suite_tests_(tests "${suite}" 0)
+        set(named "")
+        foreach(test IN LISTS tests)
+            string(REPLACE "|" ";" test "${test}")
+            list(GET test 0 testName)
+            list(GET test 1 testLine)
+            cppunit2gtest_add_entry_("${name}.${testName}" "${name}.${testName}" "${file_${suiteFile}}" ${testLine})
+            list(APPEND named "${name}.${testName}")
+        endforeach()
+        if(DEFINED ${suite}_custom)
+            string(REPLACE ";" ":" named "${named}")
+            if(named)
+                set(named "-${named}")
+            endif()
+            cppunit2gtest_add_entry_("${name}/custom" "${name}.*${named}" "${file_${suiteFile}}" ${${suite}_custom})
+        endif()
+    endif()
+endforeach()
+
+file(WRITE "${MANIFEST}" "${manifest}")
+# The executable's path is only known when building, CTest reads it from here
+file(WRITE "${EXECUTABLE_FILE}" "set(EXECUTABLE [==[${EXECUTABLE}]==])\n")
+list(LENGTH names count)
+message(STATUS "Wrote ${count} tests to ${MANIFEST}")
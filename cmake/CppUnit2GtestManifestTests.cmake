@@ -0,0 +1,227 @@
+# Adds the CTest tests of a manifest written by CppUnit2GtestManifest.cmake, included by CTest through the
+#  TEST_INCLUDE_FILES set by cppunit2gtest_manifest_tests and cppunit2gtest_add_tests.
+#  Batches are made when CTest runs, so BY_DURATION uses the times of the last run
+
+# The suite of a manifest entry: "Suite.test", "Suite.method/*", "Suite/custom" or the typed "Template/*"
+function(cppunit2gtest_entry_suite_ result name)
+    if(name MATCHES "^(.*)/custom$")
+        set(suite "${CMAKE_MATCH_1}")
+    elseif(name MATCHES "^([^.]*)\\.")
+        set(suite "${CMAKE_MATCH_1}")
+    else()
+        set(suite "${name}")
+    endif()
+    set(${result} "${suite}" PARENT_SCOPE)
+endfunction()
+
+# Milliseconds each test took in the gtest xml results of earlier batches, as "Suite.test|ms"
+function(cppunit2gtest_read_durations_ result resultsDir)
+    set(durations "")
+    file(GLOB files "${resultsDir}/*.xml")
+    foreach(xml IN LISTS files)
+        file(READ "${xml}" content)
+        string(REPLACE ";" " " content "${content}")
+        string(REPLACE "[" " " content "${content}")
+        string(REPLACE "]" " " content "${content}")
+        string(REGEX MATCHALL "<testcase [^>]*>" cases "${content}")
+        foreach(case IN LISTS cases)
+            if(NOT case MATCHES " name=\"([^\"]*)\"")
+                continue()
+            endif()
+            set(test "${CMAKE_MATCH_1}")
+            if(NOT case MATCHES " classname=\"([^\"]*)\"")
+                continue()
+            endif()
+            set(test "${CMAKE_MATCH_1}.${test}")
+            # math() has no decimals
+            if(NOT case MATCHES " time=\"([0-9]*)\\.?([0-9]*)\"")
+                continue()
+            endif()
+            set(seconds "${CMAKE_MATCH_1}")
+            if(NOT seconds)
+                set(seconds 0)
+            endif()
+            # The leading 1 keeps "050" decimal
+            string(SUBSTRING "${CMAKE_MATCH_2}000" 0 3 fraction)
+            math(EXPR ms "${seconds} * 1000 + 1${fraction} - 1000")
+            list(APPEND durations "${test}|${ms}")
+        endforeach()
+    endforeach()
+    set(${result} "${durations}" PARENT_SCOPE)
+endfunction()
+
+# Adds one CTest test running the gtest filter, an entry that matches no test fails rather than passing vacuously
+function(cppunit2gtest_add_filter_test_ name filter)
+    add_test("${name}" "${EXECUTABLE}" "--gtest_filter=${filter}" ${ARGN} ${EXTRA_ARGS})
+    set_tests_properties("${name}" PROPERTIES
+        PASS_REGULAR_EXPRESSION "\\[  PASSED  \\] [1-9]"
+        FAIL_REGULAR_EXPRESSION "\\[  FAILED  \\]")
+    if(WORKING_DIRECTORY)
+        set_tests_properties("${name}" PROPERTIES WORKING_DIRECTORY "${WORKING_DIRECTORY}")
+    endif()
+    if(PROPERTIES)
+        set_tests_properties("${name}" PROPERTIES ${PROPERTIES})
+    endif()
+endfunction()
+
+# config and executableFile are written by cppunit2gtest_manifest_tests and the build step
+function(cppunit2gtest_add_manifest_tests_ config executableFile)
+    # TARGET, MANIFEST, TEST_PREFIX, EXTRA_ARGS, WORKING_DIRECTORY, PROPERTIES, MODE, MODE_VALUE and RESULTS_DIR
+    include("${config}")
+    include("${executableFile}")
+    file(READ "${MANIFEST}" manifest)
+    string(REPLACE "\n" ";" lines "${manifest}")
+    set(entries "")
+    foreach(line IN LISTS lines)
+        if(line)
+            string(REPLACE "\t" ";" fields "${line}")
+            list(GET fields 0 name)
+            list(GET fields 1 filter)
+            list(APPEND entries "${name}|${filter}")
+        endif()
+    endforeach()
+
+    if(NOT MODE)
+        foreach(entry IN LISTS entries)
+            string(REPLACE "|" ";" entry "${entry}")
+            list(GET entry 0 name)
+            list(GET entry 1 filter)
+            cppunit2gtest_add_filter_test_("${TEST_PREFIX}${name}" "${filter}")
+        endforeach()
+        return()
+    endif()
+
+    # Each batch is a list of filters, custom tests' negative patterns can't be joined with others
+    set(batches 0)
+    if(MODE STREQUAL "PER_SUITE")
+        set(suites "")
+        foreach(entry IN LISTS entries)
+            string(REGEX REPLACE "\\|.*$" "" name "${entry}")
+            cppunit2gtest_entry_suite_(suite "${name}")
+            list(FIND suites "${suite}" index)
+            if(index EQUAL -1)
+                list(APPEND suites "${suite}")
+                set(batch_${batches} "${suite}.*")
+                set(batchName_${batches} "${suite}")
+                math(EXPR batches "${batches} + 1")
+            endif()
+        endforeach()
+    elseif(MODE STREQUAL "BATCH_SIZE")
+        set(filled 0)
+        foreach(entry IN LISTS entries)
+            string(REGEX REPLACE "^[^|]*\\|" "" filter "${entry}")
+            if(filter MATCHES "\\.\\*-")
+                set(batch_${batches} "${filter}")
+                math(EXPR batches "${batches} + 1")
+                continue()
+            endif()
+            if(filled EQUAL 0)
+                set(current ${batches})
+                set(batch_${current} "")
+                math(EXPR batches "${batches} + 1")
+            endif()
+            list(APPEND batch_${current} "${filter}")
+            math(EXPR filled "(${filled} + 1) % ${MODE_VALUE}")
+        endforeach()
+    else()
+        # BY_DURATION, tests that haven't run yet count as 100ms
+        cppunit2gtest_read_durations_(durations "${RESULTS_DIR}")
+        foreach(duration IN LISTS durations)
+            string(REPLACE "|" ";" duration "${duration}")
+            list(GET duration 0 test)
+            list(GET duration 1 ms)
+            set(known_${test} ${ms})
+        endforeach()
+        set(total 0)
+        set(sized "")
+        set(alone "")
+        foreach(entry IN LISTS entries)
+            string(REPLACE "|" ";" entry "${entry}")
+            list(GET entry 0 name)
+            list(GET entry 1 filter)
+            if(filter MATCHES "\\.\\*-")
+                list(APPEND alone "${filter}")
+                continue()
+            endif()
+            if(DEFINED known_${name})
+                set(ms ${known_${name}})
+            elseif(filter MATCHES "\\*")
+                # All the tests the pattern names, "Template/*.*" or "Suite.method/*"
+                string(REGEX REPLACE "\\*.*$" "" prefix "${filter}")
+                string(LENGTH "${prefix}" prefixLength)
+                set(ms 0)
+                foreach(duration IN LISTS durations)
+                    string(SUBSTRING "${duration}" 0 ${prefixLength} start)
+                    if(start STREQUAL prefix)
+                        string(REGEX REPLACE "^.*\\|" "" time "${duration}")
+                        math(EXPR ms "${ms} + ${time}")
+                    endif()
+                endforeach()
+                if(ms EQUAL 0)
+                    set(ms 100)
+                endif()
+            else()
+                set(ms 100)
+            endif()
+            math(EXPR total "${total} + ${ms}")
+            # Zero padded so the string sort orders numbers
+            string(LENGTH "${ms}" digits)
+            math(EXPR padding "12 - ${digits}")
+            string(REPEAT "0" ${padding} zeros)
+            list(APPEND sized "${zeros}${ms}|${filter}")
+        endforeach()
+
+        # Longest first onto the shortest batch
+        math(EXPR budget "${MODE_VALUE} * 1000")
+        math(EXPR count "(${total} + ${budget} - 1) / ${budget}")
+        list(LENGTH sized entryCount)
+        if(count GREATER entryCount)
+            set(count ${entryCount})
+        endif()
+        list(SORT sized ORDER DESCENDING)
+        set(batches ${count})
+        if(count GREATER 0)
+            math(EXPR last "${count} - 1")
+            foreach(batch RANGE ${last})
+                set(batch_${batch} "")
+                set(batchMs_${batch} 0)
+            endforeach()
+            foreach(entry IN LISTS sized)
+                string(REGEX MATCH "^([0-9]+)\\|(.*)$" unused "${entry}")
+                math(EXPR ms "${CMAKE_MATCH_1}")
+                set(filter "${CMAKE_MATCH_2}")
+                set(shortest 0)
+                foreach(batch RANGE ${last})
+                    if(batchMs_${batch} LESS batchMs_${shortest})
+                        set(shortest ${batch})
+                    endif()
+                endforeach()
+                list(APPEND batch_${shortest} "${filter}")
+                math(EXPR batchMs_${shortest} "${batchMs_${shortest}} + ${ms}")
+            endforeach()
+        endif()
+        foreach(filter IN LISTS alone)
+            set(batch_${batches} "${filter}")
+            math(EXPR batches "${batches} + 1")
+        endforeach()
+    endif()
+
+    # Every batch keeps the result of each of its tests in its own xml file
+    file(MAKE_DIRECTORY "${RESULTS_DIR}")
+    if(batches GREATER 0)
+        math(EXPR last "${batches} - 1")
+        foreach(batch RANGE ${last})
+            if(NOT batch_${batch})
+                continue()
+            endif()
+            if(DEFINED batchName_${batch})
+                set(name "${TEST_PREFIX}${batchName_${batch}}")
+            else()
+                set(name "${TEST_PREFIX}${TARGET}/${batch}")
+            endif()
+            string(REPLACE ";" ":" filter "${batch_${batch}}")
+            string(MAKE_C_IDENTIFIER "${name}" file)
+            cppunit2gtest_add_filter_test_("${name}" "${filter}" "--gtest_output=xml:${RESULTS_DIR}/${file}.xml")
+        endforeach()
+    endif()
+endfunction()
@@ -23,8 +23,25 @@ function(create_file_link source_file target_file)
     endif()
 endfunction()
 
+# create_header_alias(<source_file> <target_file> [PORTABILITY|ASSERT])
+#  The optional layer makes the alias only include that part of the header
 function(create_header_alias source_file target_file)
     # Write an include to the target file
     # The ifndef is not strictly necessary but might reduce compile time
-    file(WRITE "${target_file}" "#ifndef CPPUNIT_TO_GTEST_HEADER_ \n#include \"${source_file}\"\n#endif\n")
+    if(ARGV2 STREQUAL "PORTABILITY")
+        set(guard CPPUNIT_TO_GTEST_PORTABILITY_HEADER_)
+        set(layer 1)
+    elseif(ARGV2 STREQUAL "ASSERT")
+        set(guard CPPUNIT_TO_GTEST_ASSERT_HEADER_)
+        set(layer 2)
+    else()
+        file(WRITE "${target_file}" "#ifndef CPPUNIT_TO_GTEST_HEADER_ \n#include \"${source_file}\"\n#endif\n")
+        return()
+    endif()
+    file(WRITE "${target_file}"
+        "#ifndef ${guard}\n"
+        "#define CppUnit2Gtest_IncludeLayer_ ${layer}\n"
+        "#include \"${source_file}\"\n"
+        "#undef CppUnit2Gtest_IncludeLayer_\n"
+        "#endif\n")
 endfunction()
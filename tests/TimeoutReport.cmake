@@ -0,0 +1,24 @@
+# Runs a test that overruns its deadline, the run is aborted but gtest's xml report must still have the timeout
+#  cmake -DEXECUTABLE=<test executable> -DREPORT=<xml file> -P TimeoutReport.cmake
+file(REMOVE "${REPORT}")
+# Aborting skips the cleanup of the files the tests made, keep them somewhere to remove afterwards
+set(temporary "${REPORT}.tmp")
+file(REMOVE_RECURSE "${temporary}")
+file(MAKE_DIRECTORY "${temporary}")
+set(ENV{TEST_TMPDIR} "${temporary}")
+execute_process(
+    COMMAND "${EXECUTABLE}" --gtest_also_run_disabled_tests
+        --gtest_filter=QuickWithDeadline.DISABLED_overrunsItsDeadline "--gtest_output=xml:${REPORT}"
+    RESULT_VARIABLE result
+    OUTPUT_QUIET ERROR_QUIET)
+file(REMOVE_RECURSE "${temporary}")
+if(result EQUAL 0)
+    message(FATAL_ERROR "The test overran its deadline without stopping the run")
+endif()
+if(NOT EXISTS "${REPORT}")
+    message(FATAL_ERROR "The run was aborted without writing ${REPORT}")
+endif()
+file(READ "${REPORT}" report)
+if(NOT report MATCHES "DISABLED_overrunsItsDeadline timed out after 50 ms")
+    message(FATAL_ERROR "${REPORT} doesn't record the timeout:\n${report}")
+endif()
@@ -0,0 +1,5 @@
+#ifndef CPPUNIT_TO_GTEST_ASSERT_HEADER_
+#define CppUnit2Gtest_IncludeLayer_ 2
+#include "../CppUnit2Gtest.hpp"
+#undef CppUnit2Gtest_IncludeLayer_
+#endif
@@ -0,0 +1,3 @@
+#ifndef CPPUNIT_TO_GTEST_HEADER_ 
+#include "../CppUnit2Gtest.hpp"
+#endif
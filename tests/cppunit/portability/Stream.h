@@ -0,0 +1,5 @@
+#ifndef CPPUNIT_TO_GTEST_PORTABILITY_HEADER_
+#define CppUnit2Gtest_IncludeLayer_ 1
+#include "../CppUnit2Gtest.hpp"
+#undef CppUnit2Gtest_IncludeLayer_
+#endif
@@ -100,6 +100,9 @@ class DatabaseTestCppUnit2Gtest : public CppUnit::TestCase {
     CPPUNIT_TEST_SUITE_END();
  public:
     static Database* database;
+    // Tests share (and can change) the suite's state, to give each test its own
+    //  copy-on-write snapshot of it enable CppUnit2Gtest_EnableForkIsolation and add
+    //  CPPUNIT_TEST_SUITE_PROPERTY( "isolation", "fork" ) to the suite
 
     static void SetUpTestSuite() {
         // Call the google test function that runs once 
@@ -0,0 +1,85 @@
+/// Tests running test methods as benchmarks when CppUnit2Gtest_EnableBenchmarks is defined
+
+#define CppUnit2Gtest_EnableBenchmarks
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using ::CppUnit::to::gtest::BenchmarkSettings;
+    using ::CppUnit::to::gtest::RunBenchmark_;
+    using ::CppUnit::to::gtest::SampleStatistics;
+
+    struct BenchmarkedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( BenchmarkedSuite );
+        CPPUNIT_TEST( fillsTheBuffer );
+        CPPUNIT_BENCHMARK( fillsTheBuffer );
+        CPPUNIT_TEST_SUITE_END();
+
+        std::vector<int> buffer;
+
+        void setUp() override { buffer.clear(); }
+
+        void fillsTheBuffer() {
+            buffer.push_back(static_cast<int>(buffer.size()));
+            CPPUNIT_ASSERT(!buffer.empty());
+        }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( BenchmarkedSuite );
+
+    BenchmarkSettings QuickSettings() {
+        BenchmarkSettings settings;
+        settings.samples = 5;
+        settings.minTime = std::chrono::milliseconds(5);
+        settings.warmup = std::chrono::milliseconds(1);
+        return settings;
+    }
+
+    TEST(Benchmarks, AreRegisteredDisabled) {
+        const auto* unitTest = ::testing::UnitTest::GetInstance();
+        std::vector<std::string> names;
+        for (int i = 0; i < unitTest->total_test_suite_count(); ++i) {
+            const auto* testSuite = unitTest->GetTestSuite(i);
+            if (std::string(testSuite->name()) != "BenchmarkedSuite") { continue; }
+            for (int j = 0; j < testSuite->total_test_count(); ++j) {
+                names.emplace_back(testSuite->GetTestInfo(j)->name());
+            }
+        }
+        EXPECT_EQ(names, (std::vector<std::string>{"fillsTheBuffer", "DISABLED_BENCHMARK_fillsTheBuffer"}));
+    }
+
+    TEST(Benchmarks, SampleStatistics) {
+        const auto statistics = SampleStatistics::Of({5, 1, 4, 2, 3});
+        EXPECT_EQ(statistics.count, 5u);
+        EXPECT_DOUBLE_EQ(statistics.mean, 3);
+        EXPECT_DOUBLE_EQ(statistics.median, 3);
+        EXPECT_DOUBLE_EQ(statistics.p99, 5);
+        EXPECT_DOUBLE_EQ(statistics.min, 1);
+        EXPECT_DOUBLE_EQ(statistics.max, 5);
+        EXPECT_NEAR(statistics.stddev, 1.5811, 1e-4);
+        EXPECT_DOUBLE_EQ(SampleStatistics::Of({1, 2, 3, 4}).median, 2.5);
+        EXPECT_EQ(SampleStatistics::Of({}).count, 0u);
+    }
+
+    TEST(Benchmarks, ResetsBetweenSamples) {
+        unsigned long long calls = 0;
+        unsigned long long sinceReset = 0;
+        unsigned resets = 0;
+        const auto result = RunBenchmark_(
+            [&]() { ++calls; ++sinceReset; },
+            [&]() { ++resets; sinceReset = 0; },
+            QuickSettings());
+        EXPECT_EQ(resets, 5u);
+        EXPECT_EQ(result.nanoseconds.count, 5u);
+        EXPECT_GE(result.iterationsPerSample, 1u);
+        EXPECT_EQ(sinceReset, result.iterationsPerSample);
+        EXPECT_GT(calls, 5 * result.iterationsPerSample);
+        EXPECT_LE(result.nanoseconds.median, result.nanoseconds.p99);
+        EXPECT_GT(result.IterationsPerSecond(), 0);
+        EXPECT_EQ(result.name, "Benchmarks.ResetsBetweenSamples");
+    }
+}
@@ -0,0 +1,68 @@
+/// Tests adding generated tests with CPPUNIT_TEST_SUITE_ADD_CUSTOM_TESTS
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+    int built = 0;
+    int listed = 0;
+
+    struct GeneratedSuite;
+
+    /// Stands in for a directory of config files, each file is only "parsed" by its own test
+    struct ConfigFiles : ::CppUnit::to::gtest::TestGenerator<GeneratedSuite> {
+        std::vector<std::string> Names() const override {
+            ++listed;
+            return {"config_a", "config_b", "config_c"};
+        }
+        void Run(GeneratedSuite& fixture, size_t index) const override;
+    };
+
+    struct GeneratedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( GeneratedSuite );
+        CPPUNIT_TEST( plain );
+        CPPUNIT_TEST_SUITE_ADD_CUSTOM_TESTS( addTests );
+        CPPUNIT_TEST_SUITE_END();
+
+        bool setUpCalled = false;
+        void setUp() override { setUpCalled = true; }
+
+        void plain() { CPPUNIT_ASSERT(setUpCalled); }
+
+        static void addTests(::CppUnit::to::gtest::CustomTests<GeneratedSuite>& tests) {
+            tests.Add("single", [](GeneratedSuite& fixture) { CPPUNIT_ASSERT(fixture.setUpCalled); });
+            tests.Add(std::make_shared<const ConfigFiles>());
+        }
+    };
+
+    void ConfigFiles::Run(GeneratedSuite& fixture, const size_t index) const {
+        ++built;
+        const std::vector<char> heavy(1000, static_cast<char>('a' + index));
+        CPPUNIT_ASSERT(fixture.setUpCalled);
+        CPPUNIT_ASSERT_EQUAL(static_cast<char>('a' + index), heavy.back());
+    }
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( GeneratedSuite );
+
+    TEST(CustomTests, RegisteredByName) {
+        std::vector<std::string> names;
+        for (const auto& testData : GeneratedSuite::GetAllTests_()) { names.emplace_back(testData.testName); }
+        EXPECT_EQ(names, (std::vector<std::string>{"plain", "single", "config_a", "config_b", "config_c"}));
+    }
+
+    TEST(CustomTests, BuiltOnlyWhenRun) {
+        // Registration listed the names without building any test
+        EXPECT_GE(listed, 1);
+        const int before = built;
+        auto tests = GeneratedSuite::GetAllTests_();
+        GeneratedSuite fixture;
+        fixture.setUp();
+        EXPECT_EQ(built, before);
+        tests.at(3).boundMethod(fixture);
+        EXPECT_EQ(built, before + 1);
+    }
+}
@@ -0,0 +1,77 @@
+/// Tests the request handling of the test daemon used when CppUnit2Gtest_EnableDaemon is defined
+
+#define CppUnit2Gtest_EnableDaemon
+#include <cppunit/extensions/HelperMacros.h>
+#include "TemporaryFiles.h"
+
+#include <chrono>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+    using ::CppUnit::to::gtest::RequestTests;
+    using ::CppUnit::to::gtest::SendAll_;
+    using ::CppUnit::to::gtest::ServeTests;
+
+    const std::string socketPath = internal_tests::TemporaryPath("daemon.sock");
+
+    // Serves with a runner that only echoes the filter, forking gtest from inside a test isn't possible
+    struct FakeDaemon {
+        std::vector<std::string> filters;
+        int served = -1;
+        std::thread thread;
+
+        FakeDaemon() {
+            unlink(socketPath.c_str());
+            thread = std::thread([this]() {
+                served = ServeTests(socketPath, [this](const std::string& filter, int outputFd) {
+                    filters.push_back(filter);
+                    SendAll_(outputFd, "ran " + filter + "\npartial");
+                    return filter.empty() ? 0 : 3;
+                });
+            });
+            struct stat status{};
+            for (int i = 0; i < 1000 && stat(socketPath.c_str(), &status) != 0; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        ~FakeDaemon() {
+            std::ostringstream ignored;
+            RequestTests(socketPath, "quit", ignored);
+            thread.join();
+        }
+    };
+
+    TEST(Daemon, RunsRequestedFilters) {
+        FakeDaemon daemon;
+        std::ostringstream out;
+        ASSERT_EQ(RequestTests(socketPath, "run Suite.*:Other.test", out), 3);
+        ASSERT_EQ(out.str(), "ran Suite.*:Other.test\npartial");
+
+        std::ostringstream all;
+        ASSERT_EQ(RequestTests(socketPath, "run", all), 0);
+        ASSERT_EQ(daemon.filters, (std::vector<std::string>{"Suite.*:Other.test", ""}));
+    }
+
+    TEST(Daemon, RejectsUnknownRequests) {
+        FakeDaemon daemon;
+        std::ostringstream out;
+        ASSERT_EQ(RequestTests(socketPath, "walk Suite.*", out), 2);
+        ASSERT_NE(out.str().find("Unknown request"), std::string::npos);
+        ASSERT_TRUE(daemon.filters.empty());
+    }
+
+    TEST(Daemon, StopsOnQuit) {
+        {
+            FakeDaemon daemon;
+        }
+        struct stat status{};
+        ASSERT_NE(stat(socketPath.c_str(), &status), 0);
+        std::ostringstream out;
+        ASSERT_EQ(RequestTests(socketPath, "run", out), -1);
+    }
+
+} // namespace
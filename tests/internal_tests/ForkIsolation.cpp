@@ -0,0 +1,88 @@
+/// Tests running tests in forked children when CppUnit2Gtest_EnableForkIsolation is defined
+
+#define CppUnit2Gtest_EnableForkIsolation
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+    using ::CppUnit::to::gtest::RunInForkedChild_;
+
+    // Each test starts from the state built once by SetUpTestSuite, whatever the other tests did
+    struct ForkedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( ForkedSuite );
+        CPPUNIT_TEST_SUITE_PROPERTY( "isolation", "fork" );
+        CPPUNIT_TEST( changesSharedState );
+        CPPUNIT_TEST( changesSharedStateAgain );
+        CPPUNIT_TEST_SUITE_END();
+
+        static int suiteSetUps;
+        static int* shared;
+        int member = 0;
+
+        static void SetUpTestSuite() {
+            ++suiteSetUps;
+            shared = new int(0);
+        }
+        static void TearDownTestSuite() {
+            ASSERT_EQ(suiteSetUps, 1);
+            ASSERT_EQ(*shared, 0);
+            delete shared;
+        }
+        void setUp() override { ++member; }
+        void tearDown() override { CPPUNIT_ASSERT_EQUAL(1, member); }
+
+        void changesSharedState() {
+            CPPUNIT_ASSERT_EQUAL(0, (*shared)++);
+            CPPUNIT_ASSERT_EQUAL(1, member);
+        }
+        void changesSharedStateAgain() { changesSharedState(); }
+    };
+    int ForkedSuite::suiteSetUps = 0;
+    int* ForkedSuite::shared = nullptr;
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( ForkedSuite );
+
+    TEST(ForkIsolation, ReportsFailuresFromTheChild) {
+        EXPECT_FATAL_FAILURE(RunInForkedChild_([]() {}, []() { FAIL() << "fatal in child"; }, []() {}, 0), "fatal in child");
+        EXPECT_NONFATAL_FAILURE(RunInForkedChild_([]() {}, []() { ADD_FAILURE() << "in child"; }, []() {}, 0), "in child");
+        EXPECT_NONFATAL_FAILURE(RunInForkedChild_([]() {}, []() { throw std::runtime_error("boom"); }, []() {}, 0), "boom");
+    }
+
+    TEST(ForkIsolation, FailedSetUpSkipsTheBody) {
+        EXPECT_FATAL_FAILURE(RunInForkedChild_(
+            []() { FAIL() << "set up failed"; },
+            []() { ADD_FAILURE() << "body ran"; },
+            []() {}, 0), "set up failed");
+    }
+
+    TEST(ForkIsolation, ReportsCrashes) {
+        EXPECT_NONFATAL_FAILURE(RunInForkedChild_([]() {}, []() { std::abort(); }, []() {}, 0), "killed by signal");
+        EXPECT_NONFATAL_FAILURE(RunInForkedChild_([]() {}, []() { std::exit(3); }, []() {}, 0), "exited with code 3");
+    }
+
+    TEST(ForkIsolation, RecordsPropertiesFromTheChild) {
+        RunInForkedChild_([]() {}, []() {
+            ::testing::Test::RecordProperty("from_child", "value\nwith a newline");
+            ::testing::Test::RecordProperty("count", 2);
+        }, []() {}, 0);
+        const auto* result = ::testing::UnitTest::GetInstance()->current_test_info()->result();
+        ASSERT_EQ(result->test_property_count(), 2);
+        EXPECT_STREQ(result->GetTestProperty(0).key(), "from_child");
+        EXPECT_STREQ(result->GetTestProperty(0).value(), "value\nwith a newline");
+        EXPECT_STREQ(result->GetTestProperty(1).value(), "2");
+    }
+
+    TEST(ForkIsolation, KillsChildrenOnTheirDeadline) {
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_NONFATAL_FAILURE(RunInForkedChild_([]() {}, []() {
+            std::this_thread::sleep_for(std::chrono::seconds(10));
+        }, []() {}, 50), "timed out after 50 ms");
+        ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    }
+
+} // namespace
@@ -0,0 +1,88 @@
+/// Tests file and golden file assertions when CppUnit2Gtest_EnableGoldenFiles is defined
+
+#define CppUnit2Gtest_EnableGoldenFiles
+#include <cppunit/extensions/HelperMacros.h>
+#include <gtest/gtest-spi.h>
+#include "TemporaryFiles.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using internal_tests::TemporaryFile;
+
+    std::string writeFile(const std::string& name, const std::string& content) {
+        const std::string path = TemporaryFile(name);
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    std::string difference(const std::string& actual, const std::string& expected) {
+        return ::CppUnit::to::gtest::CompareFiles_(writeFile("actual.txt", actual), writeFile("expected.txt", expected)).message();
+    }
+
+    struct GoldenSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( GoldenSuite );
+        CPPUNIT_TEST( matchesItsGolden );
+        CPPUNIT_TEST_SUITE_END();
+
+        void matchesItsGolden() {
+            const std::string output = writeFile("output.txt", "same\n");
+            CPPUNIT_ASSERT_FILES_EQUAL(output, writeFile("copy.txt", "same\n"));
+            CPPUNIT_ASSERT_MATCHES_GOLDEN_MESSAGE("golden", output, writeFile("golden.txt", "same\n"));
+        }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( GoldenSuite );
+
+    TEST(GoldenFiles, ComparesAcrossBlocks) {
+        std::string large(3 * (1u << 20) + 17, 'x');
+        EXPECT_TRUE(::CppUnit::to::gtest::CompareFiles_(writeFile("large_a.txt", large), writeFile("large_b.txt", large)));
+        const std::string expected = large;
+        large[2 * (1u << 20) + 5] = 'y';
+        EXPECT_NE(difference(large, expected).find("first difference at byte 2097157 (line 1, column 2097158)"), std::string::npos);
+        EXPECT_TRUE(::CppUnit::to::gtest::CompareFiles_(writeFile("empty_a.txt", ""), writeFile("empty_b.txt", "")));
+    }
+
+    TEST(GoldenFiles, ShowsTheDifferingLines) {
+        const auto message = difference("one\ntwo\nthree\n", "one\ntwo\nthrEe\n");
+        EXPECT_NE(message.find("(line 3, column 4)"), std::string::npos) << message;
+        EXPECT_NE(message.find("  actual:   three\n  expected: thrEe\n               ^"), std::string::npos) << message;
+        const auto prefix = difference("one\n", "one\ntwo\n");
+        EXPECT_NE(prefix.find("at byte 4 (line 2, column 1), sizes 4 and 8 bytes"), std::string::npos) << prefix;
+    }
+
+    TEST(GoldenFiles, DumpsBinaryAsHex) {
+        const auto message = difference(std::string("\x01\x02\x03", 3), std::string("\x01\x02\x04", 3));
+        EXPECT_NE(message.find("actual  : 01 02[03"), std::string::npos) << message;
+        EXPECT_NE(message.find("expected: 01 02[04"), std::string::npos) << message;
+    }
+
+    TEST(GoldenFiles, ReportsMissingFiles) {
+        static const std::string existing = writeFile("exists.txt", "x");
+        EXPECT_FATAL_FAILURE(CPPUNIT_ASSERT_FILES_EQUAL(existing, existing + ".missing"), "cannot open");
+    }
+
+    TEST(GoldenFiles, UpdatesGoldenWhenAsked) {
+        const std::string actual = writeFile("new_output.txt", "new\n");
+        const std::string golden = writeFile("stale_golden.txt", "old\n");
+        EXPECT_FALSE(::CppUnit::to::gtest::MatchesGolden_("", "", actual, golden));
+        setenv("CPPUNIT2GTEST_UPDATE_GOLDEN", "1", 1);
+        EXPECT_TRUE(::CppUnit::to::gtest::MatchesGolden_("", "", actual, golden));
+        EXPECT_TRUE(::CppUnit::to::gtest::MatchesGolden_("", "", actual, TemporaryFile("stale_golden.txt.created")));
+        unsetenv("CPPUNIT2GTEST_UPDATE_GOLDEN");
+        EXPECT_EQ(readFile(golden), "new\n");
+        EXPECT_EQ(readFile(golden + ".created"), "new\n");
+        EXPECT_TRUE(::CppUnit::to::gtest::MatchesGolden_("", "", actual, golden));
+    }
+}
@@ -0,0 +1,58 @@
+/// Tests the CppUnit style shim headers only include the layers of the header they need
+
+#include <cppunit/portability/Stream.h>
+
+#if defined(CPPUNIT_TO_GTEST_ASSERT_HEADER_) || defined(CPPUNIT_TO_GTEST_HEADER_)
+#   error "cppunit/portability/Stream.h should only include the portability layer"
+#endif
+#if defined(GTEST_INCLUDE_GTEST_GTEST_H_) || defined(GOOGLETEST_INCLUDE_GTEST_GTEST_H_)
+#   error "cppunit/portability/Stream.h should not include gtest"
+#endif
+
+#include <sstream>
+#include <string>
+
+namespace header_layers {
+    std::string version() {
+        std::ostringstream stream;
+        CppUnit::OStream& out = stream;
+        out << CPPUNIT_VERSION;
+        return stream.str();
+    }
+}
+
+#include <cppunit/TestAssert.h>
+
+#if !defined(CPPUNIT_TO_GTEST_ASSERT_HEADER_) || defined(CPPUNIT_TO_GTEST_HEADER_)
+#   error "cppunit/TestAssert.h should include the assertions and nothing more"
+#endif
+#if defined(CppUnit2Gtest_IncludeLayer_)
+#   error "The shim headers should not leave CppUnit2Gtest_IncludeLayer_ defined"
+#endif
+
+namespace header_layers {
+    void checkVersion(const std::string& value) {
+        CPPUNIT_ASSERT_EQUAL(std::string("CppUnit2Gtest"), value);
+    }
+}
+
+#include <cppunit/extensions/HelperMacros.h>
+// Asking for a smaller layer afterwards doesn't change anything
+#include <cppunit/config/SourcePrefix.h>
+
+#if !defined(CPPUNIT_TO_GTEST_HEADER_)
+#   error "cppunit/extensions/HelperMacros.h should include everything"
+#endif
+
+namespace {
+
+    struct LayeredSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( LayeredSuite );
+        CPPUNIT_TEST( usesEveryLayer );
+        CPPUNIT_TEST_SUITE_END();
+
+        void usesEveryLayer() { header_layers::checkVersion(header_layers::version()); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( LayeredSuite );
+}
@@ -0,0 +1,74 @@
+/// Tests test locations and the selection used when CppUnit2Gtest_EnableImpactSelection is defined
+
+#define CppUnit2Gtest_EnableImpactSelection
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sstream>
+
+namespace {
+
+    using ::CppUnit::to::gtest::ImpactSelection;
+
+    struct ImpactedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( ImpactedSuite );
+        CPPUNIT_TEST( located );
+        CPPUNIT_TEST_SUITE_END();
+        void located() { CPPUNIT_ASSERT( true ); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( ImpactedSuite );
+
+    const ::testing::TestInfo* FindTest(const std::string& suite, const std::string& name) {
+        const auto* unitTest = ::testing::UnitTest::GetInstance();
+        for (int i = 0; i < unitTest->total_test_suite_count(); ++i) {
+            const auto* testSuite = unitTest->GetTestSuite(i);
+            if (suite != testSuite->name()) { continue; }
+            for (int j = 0; j < testSuite->total_test_count(); ++j) {
+                if (name == testSuite->GetTestInfo(j)->name()) { return testSuite->GetTestInfo(j); }
+            }
+        }
+        return nullptr;
+    }
+
+    TEST(ImpactSelection, TestsAreRegisteredAtTheirLocation) {
+        const auto* info = FindTest("ImpactedSuite", "located");
+        ASSERT_NE(info, nullptr);
+        ASSERT_TRUE(ImpactSelection::SamePath("internal_tests/ImpactSelection.cpp", info->file())) << info->file();
+        ASSERT_EQ(info->line(), 14);
+    }
+
+    TEST(ImpactSelection, PathsMatchOnWholeComponents) {
+        ASSERT_TRUE(ImpactSelection::SamePath("src/a.cpp", "src/a.cpp"));
+        ASSERT_TRUE(ImpactSelection::SamePath("/home/me/repo/src/a.cpp", "src/a.cpp"));
+        ASSERT_TRUE(ImpactSelection::SamePath("src/a.cpp", "/home/me/repo/src/a.cpp"));
+        ASSERT_FALSE(ImpactSelection::SamePath("/home/me/repo/src/data.cpp", "a.cpp"));
+        ASSERT_FALSE(ImpactSelection::SamePath("src/a.cpp", "src/b.cpp"));
+        ASSERT_FALSE(ImpactSelection::SamePath("", "src/a.cpp"));
+    }
+
+    TEST(ImpactSelection, ReadsMapAndChangedFiles) {
+        std::istringstream map{"Suite.a\t/repo/src/a.cpp\t/repo/src/common.hpp\nSuite.b\n\nSuite.c\t/repo/src/c.cpp\n"};
+        const auto coverage = ImpactSelection::ReadCoverageMap(map);
+        ASSERT_EQ(coverage.size(), 3u);
+        ASSERT_EQ(coverage.at("Suite.a"), (std::vector<std::string>{"/repo/src/a.cpp", "/repo/src/common.hpp"}));
+        ASSERT_TRUE(coverage.at("Suite.b").empty());
+
+        std::istringstream changed{"src/common.hpp\r\n\nsrc/other.cpp\n"};
+        ASSERT_EQ(ImpactSelection::ReadChangedFiles(changed), (std::vector<std::string>{"src/common.hpp", "src/other.cpp"}));
+    }
+
+    TEST(ImpactSelection, SelectsTestsThatCannotBeRuledOut) {
+        ImpactSelection selection{{"src/common.hpp", "tests/SuiteB.cpp"}, {
+            {"Suite.covers", {"/repo/src/a.cpp", "/repo/src/common.hpp"}},
+            {"Suite.unrelated", {"/repo/src/a.cpp"}},
+            {"Suite.ownFile", {"/repo/src/a.cpp"}},
+        }};
+        ASSERT_TRUE(selection.IsImpacted("Suite", "covers", "/repo/tests/SuiteA.cpp"));
+        ASSERT_FALSE(selection.IsImpacted("Suite", "unrelated", "/repo/tests/SuiteA.cpp"));
+        ASSERT_TRUE(selection.IsImpacted("Suite", "ownFile", "/repo/tests/SuiteB.cpp"));
+        ASSERT_TRUE(selection.IsImpacted("Suite", "new", "/repo/tests/SuiteA.cpp"));
+        ASSERT_EQ(selection.selectedCount, 3u);
+        ASSERT_EQ(selection.totalCount, 4u);
+    }
+
+} // namespace
@@ -0,0 +1,136 @@
+/// Tests CPPUNIT_TEST_PARAMETERIZED, with memory mapped sources when CppUnit2Gtest_EnableMappedParameters is defined
+
+#define CppUnit2Gtest_EnableMappedParameters
+#include <cppunit/extensions/HelperMacros.h>
+#include <gtest/gtest-spi.h>
+#include "TemporaryFiles.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+    using ::CppUnit::to::gtest::MappedParameters;
+    using ::CppUnit::to::gtest::ParameterChunks;
+    using internal_tests::TemporaryFile;
+
+    // Per process, other runs of the binary may have theirs mapped while this one registers
+    const std::string& linesPath() {
+        static const std::string path = []() {
+            const std::string created = TemporaryFile("parameters.txt");
+            std::ofstream out(created);
+            for (int i = 0; i < 250; ++i) { out << i << (i % 2 == 0 ? "\n" : "\r\n"); }
+            return created;
+        }();
+        return path;
+    }
+
+    struct ParameterizedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( ParameterizedSuite );
+        CPPUNIT_TEST_PARAMETERIZED( isSmall, {1, 2, 3} );
+        CPPUNIT_TEST_PARAMETERIZED( hasLength, std::vector<std::string>{"a", "bb"} );
+        CPPUNIT_TEST_PARAMETERIZED( isNumber, MappedParameters::Lines(linesPath()) );
+        CPPUNIT_TEST_SUITE_END();
+
+        int setUps = 0;
+        bool used = false;
+        void setUp() override {
+            ++setUps;
+            used = false;
+        }
+
+        void isSmall(const int value) {
+            CPPUNIT_ASSERT(!used);
+            used = true;
+            CPPUNIT_ASSERT(value > 0 && value < 4);
+        }
+        void hasLength(const std::string& value) { CPPUNIT_ASSERT(!value.empty()); }
+        void isNumber(const std::string_view line) {
+            CPPUNIT_ASSERT(!used);
+            used = true;
+            CPPUNIT_ASSERT(!line.empty());
+            CPPUNIT_ASSERT(line.find_first_not_of("0123456789") == std::string_view::npos);
+        }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( ParameterizedSuite );
+
+    std::vector<std::string> registeredNames(const std::string& suiteName) {
+        std::vector<std::string> names;
+        const auto* unitTest = ::testing::UnitTest::GetInstance();
+        for (int i = 0; i < unitTest->total_test_suite_count(); ++i) {
+            const auto* testSuite = unitTest->GetTestSuite(i);
+            if (testSuite->name() != suiteName) { continue; }
+            for (int j = 0; j < testSuite->total_test_count(); ++j) { names.emplace_back(testSuite->GetTestInfo(j)->name()); }
+        }
+        return names;
+    }
+
+    TEST(Parameterized, RegistersSmallSourcesPerCase) {
+        const auto names = registeredNames("ParameterizedSuite");
+        ASSERT_GE(names.size(), 5u);
+        EXPECT_EQ(std::vector<std::string>(names.begin(), names.begin() + 5),
+            (std::vector<std::string>{"isSmall/0", "isSmall/1", "isSmall/2", "hasLength/0", "hasLength/1"}));
+    }
+
+    TEST(Parameterized, ChunksLargeSources) {
+        EXPECT_EQ(::CppUnit::to::gtest::EvenChunks_(250, 100).size(), 100u);
+        EXPECT_EQ(::CppUnit::to::gtest::EvenChunks_(5, 2), (ParameterChunks{{0, 2}, {2, 5}}));
+        // Chunks of lines cover the file, start at lines and aren't empty
+        const auto chunks = MappedParameters::Lines(linesPath()).Chunks(100);
+        ASSERT_FALSE(chunks.empty());
+        EXPECT_LE(chunks.size(), 100u);
+        EXPECT_EQ(chunks.front().first, 0u);
+        for (size_t i = 1; i < chunks.size(); ++i) {
+            EXPECT_EQ(chunks[i].first, chunks[i - 1].second);
+            EXPECT_LT(chunks[i].first, chunks[i].second);
+        }
+        size_t lines = 0;
+        std::string joined;
+        const auto source = MappedParameters::Lines(linesPath());
+        for (const auto& chunk : chunks) {
+            source.ForEach(chunk.first, chunk.second, [&](const std::string_view line, size_t) {
+                ++lines;
+                joined += std::string(line) + ",";
+            });
+        }
+        EXPECT_EQ(lines, 250u);
+        EXPECT_EQ(joined.substr(0, 8), "0,1,2,3,");
+    }
+
+    TEST(Parameterized, MapsRecords) {
+        const std::string path = TemporaryFile("records.bin");
+        std::ofstream(path) << "aabbccd";
+        const auto source = MappedParameters::Records(path, 2);
+        EXPECT_EQ(source.Chunks(100), (ParameterChunks{{0, 1}, {1, 2}, {2, 3}}));
+        std::string records;
+        source.ForEach(1, 3, [&](const std::string_view record, size_t) { records += std::string(record) + ";"; });
+        EXPECT_EQ(records, "bb;cc;");
+        std::remove(path.c_str());
+        EXPECT_NE(MappedParameters::Lines("/nonexistent/CppUnit2Gtest").Error(), "");
+    }
+
+    struct Checked : CPPUNIT_NS::TestFixture {
+        int setUps = 0;
+        void setUp() override { ++setUps; }
+        void TestBody() override {}
+    };
+
+    TEST(Parameterized, FailuresNameTheCase) {
+        static std::vector<::CppUnit::to::gtest::TestData<Checked>> tests;
+        static Checked fixture;
+        std::vector<int> values(300);
+        for (size_t i = 0; i < values.size(); ++i) { values[i] = static_cast<int>(i); }
+        ::CppUnit::to::gtest::AddParameterizedTests_(tests, "check", 1, "Parameterized.cpp",
+            ::CppUnit::to::gtest::ParametersOf_(values), [](Checked&, const int value) { CPPUNIT_ASSERT(value != 1); });
+        ASSERT_EQ(tests.size(), 100u);
+        EXPECT_STREQ(tests.front().testName, "check/0-2");
+        EXPECT_STREQ(tests.back().testName, "check/297-299");
+        // The other cases of the chunk still run, with setUp between them
+        EXPECT_FATAL_FAILURE(tests.front().boundMethod(fixture), "case 1");
+        EXPECT_EQ(fixture.setUps, 2);
+    }
+}
@@ -0,0 +1,90 @@
+/// Tests counting hardware events per test when CppUnit2Gtest_EnablePerfCounters is defined
+
+#define CppUnit2Gtest_EnablePerfCounters
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+    using ::CppUnit::to::gtest::PerfCounterGroup;
+    using ::CppUnit::to::gtest::PerfCounts;
+    using ::CppUnit::to::gtest::PerfSuiteTotals;
+
+    volatile unsigned long long sink = 0;
+
+    struct CountedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( CountedSuite );
+        CPPUNIT_TEST( loops );
+        CPPUNIT_TEST_SUITE_END();
+
+        void loops() {
+            for (unsigned long long i = 0; i < 100000; ++i) { sink = sink + i; }
+            CPPUNIT_ASSERT(sink > 0);
+        }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( CountedSuite );
+
+    TEST(PerfCounters, SumsAndIpc) {
+        PerfCounts a;
+        a.values[PerfCounts::cycles] = 100;
+        a.measured[PerfCounts::cycles] = true;
+        EXPECT_EQ(a.Ipc(), 0);
+        PerfCounts b;
+        b.values[PerfCounts::cycles] = 100;
+        b.values[PerfCounts::instructions] = 300;
+        b.measured[PerfCounts::cycles] = true;
+        b.measured[PerfCounts::instructions] = true;
+        a += b;
+        EXPECT_EQ(a.values[PerfCounts::cycles], 200u);
+        EXPECT_TRUE(a.measured[PerfCounts::instructions]);
+        EXPECT_DOUBLE_EQ(a.Ipc(), 1.5);
+    }
+
+    TEST(PerfCounters, TableHasMeasuredCountersOnly) {
+        std::map<std::string, PerfSuiteTotals> suites;
+        auto& suite = suites["Suite"];
+        suite.tests = 2;
+        suite.counts.values[PerfCounts::cycles] = 10;
+        suite.counts.values[PerfCounts::instructions] = 20;
+        suite.counts.measured[PerfCounts::cycles] = true;
+        suite.counts.measured[PerfCounts::instructions] = true;
+        std::ostringstream table;
+        ::CppUnit::to::gtest::WritePerfTable(table, suites);
+        EXPECT_EQ(table.str(), "suite\ttests\tcycles\tinstructions\tipc\nSuite\t2\t10\t20\t2\n");
+    }
+
+    TEST(PerfCounters, TotalsComeFromTheProperties) {
+        // As recorded by a test, or by a forked test's child and passed back
+        ::testing::Test::RecordProperty("perf_cycles", "10");
+        ::testing::Test::RecordProperty("perf_instructions", "30");
+        ::testing::Test::RecordProperty("perf_ipc", "3");
+        ::CppUnit::to::gtest::PerfCounterRecorder recorder;
+        recorder.OnTestEnd(*::testing::UnitTest::GetInstance()->current_test_info());
+        ASSERT_EQ(recorder.suites.size(), 1u);
+        const auto& totals = recorder.suites.at("PerfCounters");
+        EXPECT_EQ(totals.tests, 1u);
+        EXPECT_EQ(totals.counts.values[PerfCounts::cycles], 10u);
+        EXPECT_EQ(totals.counts.values[PerfCounts::instructions], 30u);
+        EXPECT_FALSE(totals.counts.measured[PerfCounts::l1dMisses]);
+        EXPECT_DOUBLE_EQ(totals.counts.Ipc(), 3);
+    }
+
+    TEST(PerfCounters, CountsOrExplains) {
+        PerfCounterGroup group;
+        if (!group.Available()) {
+            EXPECT_FALSE(group.Error().empty());
+            GTEST_SKIP() << "No counters: " << group.Error();
+        }
+        group.Start();
+        for (unsigned long long i = 0; i < 100000; ++i) { sink = sink + i; }
+        PerfCounts counts;
+        if (!group.Stop(counts)) { GTEST_SKIP() << "Counters were not scheduled"; }
+        EXPECT_TRUE(std::find(counts.measured.begin(), counts.measured.end(), true) != counts.measured.end());
+        if (counts.measured[PerfCounts::instructions]) { EXPECT_GT(counts.values[PerfCounts::instructions], 100000u); }
+    }
+}
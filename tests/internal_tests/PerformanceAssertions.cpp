@@ -0,0 +1,59 @@
+/// Tests the performance budget assertions when CppUnit2Gtest_EnablePerformanceAssertions is defined
+
+#define CppUnit2Gtest_EnablePerformanceAssertions
+#define CppUnit2Gtest_CountAllocations
+#include <cppunit/extensions/HelperMacros.h>
+#include <gtest/gtest-spi.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    using ::CppUnit::to::gtest::SampleStatistics;
+
+    volatile int sink = 0;
+
+    void allocateTwice() { sink = *std::make_unique<int>(1) + *std::make_unique<int>(2); }
+
+    struct BudgetedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( BudgetedSuite );
+        CPPUNIT_TEST( staysWithinBudgets );
+        CPPUNIT_TEST_SUITE_END();
+
+        void staysWithinBudgets() {
+            CPPUNIT_ASSERT_FASTER_THAN(1000000, sink = sink + 1);
+            CPPUNIT_ASSERT_FASTER_THAN_MESSAGE("increment", 1000000, sink = sink + 1);
+            CPPUNIT_ASSERT_ALLOCATES_AT_MOST(0, sink = sink + 1);
+            CPPUNIT_ASSERT_ALLOCATES_AT_MOST_MESSAGE("one int", 1, sink = *std::make_unique<int>(1));
+        }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( BudgetedSuite );
+
+    TEST(PerformanceAssertions, MedianConfidenceInterval) {
+        std::vector<double> samples;
+        for (int i = 25; i > 0; --i) { samples.push_back(i); }
+        const auto statistics = SampleStatistics::Of(samples);
+        EXPECT_DOUBLE_EQ(statistics.median, 13);
+        EXPECT_DOUBLE_EQ(statistics.medianLow, 8);
+        EXPECT_DOUBLE_EQ(statistics.medianHigh, 18);
+        const auto few = SampleStatistics::Of({2, 1});
+        EXPECT_DOUBLE_EQ(few.medianLow, 1);
+        EXPECT_DOUBLE_EQ(few.medianHigh, 2);
+    }
+
+    TEST(PerformanceAssertions, FailsOverTimeBudget) {
+        EXPECT_FATAL_FAILURE(
+            CPPUNIT_ASSERT_FASTER_THAN(1000, std::this_thread::sleep_for(std::chrono::microseconds(100))),
+            "is slower than its budget of 1000 ns");
+    }
+
+    TEST(PerformanceAssertions, FailsOverAllocationBudget) {
+        EXPECT_FATAL_FAILURE(
+            CPPUNIT_ASSERT_ALLOCATES_AT_MOST(1, allocateTwice()),
+            "allocates more than 1 times");
+    }
+}
@@ -0,0 +1,32 @@
+/// Tests loading test plugins when CppUnit2Gtest_EnablePlugins is defined,
+///  a real plugin is loaded by CppUnit2Gtest_AllTests_PluginRunner
+
+#if defined(__linux__)
+#define CppUnit2Gtest_EnablePlugins
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+namespace {
+
+    using ::CppUnit::to::gtest::LoadTestPlugin;
+    using ::CppUnit::to::gtest::LoadTestPlugins;
+
+    TEST(Plugins, MissingFile) {
+        const auto plugin = LoadTestPlugin("/nonexistent/plugin.so");
+        EXPECT_EQ(plugin.path, "/nonexistent/plugin.so");
+        EXPECT_NE(plugin.error.find("No such file"), std::string::npos) << plugin.error;
+        EXPECT_EQ(plugin.tests, 0);
+    }
+
+    TEST(Plugins, NotAPlugin) {
+        const auto plugin = LoadTestPlugin("libm.so.6");
+        EXPECT_NE(plugin.error.find("not a test plugin"), std::string::npos) << plugin.error;
+    }
+
+    TEST(Plugins, DirectoryWithoutPlugins) {
+        EXPECT_TRUE(LoadTestPlugins(::testing::TempDir() + "CppUnit2Gtest_no_plugins_here").size() == 1);
+        EXPECT_TRUE(LoadTestPlugins("/proc/self").empty());
+    }
+}
+#endif
@@ -0,0 +1,128 @@
+/// Tests the failure first ordering used when CppUnit2Gtest_EnablePrioritization is defined
+
+#define CppUnit2Gtest_EnablePrioritization
+#include <cppunit/extensions/HelperMacros.h>
+#include "TemporaryFiles.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+    using ::CppUnit::to::gtest::Prioritizer;
+    using ::CppUnit::to::gtest::TestHistory;
+
+    // Deferred and reordered when CPPUNIT2GTEST_HISTORY_FILE is set
+    struct PrioritizedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( PrioritizedSuite );
+        CPPUNIT_TEST( passes );
+        CPPUNIT_TEST_SUITE_END();
+        void passes() { CPPUNIT_ASSERT( true ); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( PrioritizedSuite );
+
+    const std::string historyPath = internal_tests::TemporaryPath("history.txt");
+    const std::string stopPath = internal_tests::TemporaryPath("stop");
+
+    TestHistory WithHistory(const std::string& text) {
+        std::istringstream in{text};
+        TestHistory history;
+        history.Load(in);
+        return history;
+    }
+
+    TEST(Prioritization, RecentFailuresThenFastTestsFirst) {
+        TestHistory history;
+        history.Record("S.slow", false, 100);
+        history.Record("S.fast", false, 1);
+        history.Record("S.failedBefore", true, 50);
+        ++history.run;
+        history.Record("S.slow", false, 100);
+        history.Record("S.fast", false, 1);
+        history.Record("S.failedBefore", false, 50);
+        history.Record("S.failedLast", true, 500);
+        ++history.run;
+
+        ASSERT_EQ(history.PriorityOf("S.failedLast").runsSinceFailure, 0u);
+        ASSERT_EQ(history.PriorityOf("S.failedBefore").runsSinceFailure, 1u);
+        ASSERT_EQ(history.PriorityOf("S.fast").runsSinceFailure, TestHistory::window);
+        ASSERT_LT(history.PriorityOf("S.failedLast"), history.PriorityOf("S.failedBefore"));
+        ASSERT_LT(history.PriorityOf("S.failedBefore"), history.PriorityOf("S.fast"));
+        ASSERT_LT(history.PriorityOf("S.unknown"), history.PriorityOf("S.fast"));
+        ASSERT_LT(history.PriorityOf("S.fast"), history.PriorityOf("S.slow"));
+    }
+
+    TEST(Prioritization, OldFailuresAndTestsAreForgotten) {
+        TestHistory history;
+        history.Record("S.failed", true, 1);
+        history.Record("S.removed", false, 1);
+        history.run += TestHistory::window;
+        history.Record("S.failed", false, 1);
+        ++history.run;
+        ASSERT_EQ(history.PriorityOf("S.failed").runsSinceFailure, TestHistory::window);
+
+        std::ostringstream out;
+        history.Save(out);
+        ASSERT_EQ(out.str().find("S.removed"), std::string::npos);
+    }
+
+    TEST(Prioritization, HistoryRoundTrips) {
+        TestHistory history;
+        history.Record("S.a", true, 12);
+        std::ostringstream out;
+        history.Save(out);
+        const auto loaded = WithHistory(out.str());
+        ASSERT_EQ(loaded.run, 2u);
+        ASSERT_EQ(loaded.PriorityOf("S.a").runsSinceFailure, 0u);
+        ASSERT_EQ(loaded.PriorityOf("S.a").durationMs, 12);
+        ASSERT_EQ(WithHistory("not a history").run, 1u);
+    }
+
+    TEST(Prioritization, SuitesAreRegisteredInPriorityOrder) {
+        std::ofstream(historyPath) << "run 1\nFast.a\t1\t0\t1\nSlow.a\t1\t0\t50\nSlow.b\t1\t0\t50\nFailed.a\t1\t0\t100\nFailed.b\t1\t1\t100\n";
+        Prioritizer prioritizer(historyPath, "", false);
+        std::vector<std::string> order;
+        for (const std::string suite : {"Slow", "Failed", "Fast", "New"}) {
+            ASSERT_TRUE(prioritizer.Defer({suite, {"a", "b"}, [&order, suite]() { order.push_back(suite); }}));
+        }
+        prioritizer.RegisterDeferred();
+        ASSERT_EQ(order, (std::vector<std::string>{"Failed", "New", "Fast", "Slow"}));
+        // Later suites are registered straight away
+        ASSERT_FALSE(prioritizer.Defer({"Late", {}, []() {}}));
+        ASSERT_FALSE(Prioritizer("", "", false).Defer({"NoHistory", {}, []() {}}));
+        std::remove(historyPath.c_str());
+    }
+
+    TEST(Prioritization, SavingMergesWithOtherWorkers) {
+        std::remove(historyPath.c_str());
+        Prioritizer first(historyPath, "", false);
+        Prioritizer second(historyPath, "", false);
+        first.Record("S.first", true, 1);
+        second.Record("S.second", false, 2);
+        first.Save();
+        second.Save();
+
+        std::ifstream in(historyPath);
+        TestHistory saved;
+        saved.Load(in);
+        ASSERT_EQ(saved.run, 2u);
+        ASSERT_EQ(saved.PriorityOf("S.first").runsSinceFailure, 0u);
+        ASSERT_EQ(saved.PriorityOf("S.second").durationMs, 2);
+        std::remove(historyPath.c_str());
+    }
+
+    TEST(Prioritization, FailuresStopOtherWorkers) {
+        std::remove(stopPath.c_str());
+        Prioritizer failing("", stopPath, true);
+        Prioritizer other("", stopPath, true);
+        ASSERT_FALSE(other.StopRequested());
+        failing.Record("S.passes", false, 1);
+        ASSERT_FALSE(other.StopRequested());
+        failing.Record("S.fails", true, 1);
+        ASSERT_TRUE(other.StopRequested());
+        std::remove(stopPath.c_str());
+    }
+
+} // namespace
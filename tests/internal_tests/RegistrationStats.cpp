@@ -0,0 +1,73 @@
+/// Tests measuring the cost of registering suites when CppUnit2Gtest_EnableRegistrationStats is defined
+
+#define CppUnit2Gtest_EnableRegistrationStats
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using ::CppUnit::to::gtest::FindRegistrationStats;
+
+    struct MeasuredSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( MeasuredSuite );
+        CPPUNIT_TEST( first );
+        CPPUNIT_TEST( second );
+        CPPUNIT_TEST_SUITE_END();
+
+        void first() {}
+        void second() {}
+    };
+
+    struct OtherMeasuredSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( OtherMeasuredSuite );
+        CPPUNIT_TEST( only );
+        CPPUNIT_TEST_SUITE_END();
+
+        void only() {}
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( MeasuredSuite );
+    CPPUNIT_TEST_SUITE_REGISTRATION( OtherMeasuredSuite );
+
+    TEST(RegistrationStats, MeasuresEachSuite) {
+        const auto stats = FindRegistrationStats("MeasuredSuite");
+        EXPECT_EQ(stats.suite, "MeasuredSuite");
+        EXPECT_EQ(stats.tests, 2u);
+        EXPECT_GE(stats.milliseconds, 0);
+        EXPECT_NE(stats.file.find("RegistrationStats.cpp"), std::string::npos);
+        EXPECT_TRUE(FindRegistrationStats("NotRegistered").suite.empty());
+    }
+
+    TEST(RegistrationStats, SumsPerFile) {
+        const auto file = FindRegistrationStats("MeasuredSuite").file;
+        bool found = false;
+        for (const auto& stats : ::CppUnit::to::gtest::RegistrationStatsByFile()) {
+            if (stats.file != file) { continue; }
+            found = true;
+            EXPECT_EQ(stats.tests, 3u);
+        }
+        EXPECT_TRUE(found);
+    }
+
+    TEST(RegistrationStats, ReportsFilesThenSuites) {
+        std::ostringstream report;
+        ::CppUnit::to::gtest::WriteRegistrationReport(report);
+        const auto text = report.str();
+        const auto suites = text.find("\nsuite\tms\tallocations\ttests\tfile\n");
+        EXPECT_EQ(text.rfind("file\tms\tallocations\ttests\tslowest suite\n", 0), 0u);
+        ASSERT_NE(suites, std::string::npos);
+        EXPECT_NE(text.find("\nMeasuredSuite\t", suites), std::string::npos);
+    }
+
+#ifdef Cpp2Unit2Gtest_EnableMainHelperClasses
+    TEST(RegistrationStats, InTheTestTree) {
+        auto* root = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+        auto* suite = dynamic_cast<::CppUnit::to::gtest::TestAdaptorSuite*>(root->findTest("MeasuredSuite"));
+        ASSERT_NE(suite, nullptr);
+        EXPECT_EQ(::CppUnit::to::gtest::RegistrationOf(*suite).tests, 2u);
+    }
+#endif
+}
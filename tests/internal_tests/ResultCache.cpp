@@ -0,0 +1,110 @@
+/// Tests the cache of passing tests used when CppUnit2Gtest_EnableResultCache is defined
+
+#define CppUnit2Gtest_EnableResultCache
+#include <cppunit/extensions/HelperMacros.h>
+#include "TemporaryFiles.h"
+
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+
+    using ::CppUnit::to::gtest::ResultCache;
+
+    // Skipped on later runs when CPPUNIT2GTEST_CACHE_DIR is set
+    struct CachedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( CachedSuite );
+        CPPUNIT_TEST( passes );
+        CPPUNIT_TEST_SUITE_END();
+        void passes() { CPPUNIT_ASSERT( true ); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( CachedSuite );
+
+    // Counts what a cached test must not run
+    struct PartlyCachedSuite : CPPUNIT_NS::TestFixture {
+        static int calls;
+        void setUp() override { ++calls; }
+        void tearDown() override { ++calls; }
+        void test() { ++calls; }
+    };
+    int PartlyCachedSuite::calls = 0;
+
+    const std::string cacheParent = internal_tests::TemporaryPath("cache");
+    const std::string cacheDirectory = cacheParent + "/results";
+
+    // The cache is per process and removed when it exits, after these strings may have been destroyed
+    const bool cacheRemoved = []() {
+        internal_tests::CleanUpAtExit([parent = cacheParent, directory = cacheDirectory]() {
+            ResultCache(directory, "binary", "", 0).Evict();
+            rmdir(directory.c_str());
+            rmdir(parent.c_str());
+        });
+        return true;
+    }();
+
+    // Starts every test with an empty cache
+    ResultCache EmptyCache(const std::string& environmentNames = "", const size_t maxEntries = 100) {
+        ResultCache(cacheDirectory, "binary", "", 0).Evict();
+        return {cacheDirectory, "binary", environmentNames, maxEntries};
+    }
+
+    TEST(ResultCache, BinaryIdentityIsStable) {
+        const auto identity = ::CppUnit::to::gtest::BinaryIdentity_();
+        ASSERT_FALSE(identity.empty());
+        ASSERT_EQ(identity, ::CppUnit::to::gtest::BinaryIdentity_());
+    }
+
+    TEST(ResultCache, KeysDependOnEverything) {
+        ResultCache cache(cacheDirectory, "binary", "", 100);
+        ResultCache otherBinary(cacheDirectory, "other binary", "", 100);
+        ASSERT_EQ(cache.Key("Suite", "test"), cache.Key("Suite", "test"));
+        ASSERT_NE(cache.Key("Suite", "test"), cache.Key("Suite", "other"));
+        ASSERT_NE(cache.Key("Suite", "test"), cache.Key("Other", "test"));
+        ASSERT_NE(cache.Key("Suite", "test"), otherBinary.Key("Suite", "test"));
+
+        setenv("CPPUNIT2GTEST_TEST_CACHE_VARIABLE", "1", 1);
+        ResultCache withVariable(cacheDirectory, "binary", "CPPUNIT2GTEST_TEST_CACHE_VARIABLE,", 100);
+        setenv("CPPUNIT2GTEST_TEST_CACHE_VARIABLE", "2", 1);
+        ResultCache withChangedVariable(cacheDirectory, "binary", "CPPUNIT2GTEST_TEST_CACHE_VARIABLE,", 100);
+        unsetenv("CPPUNIT2GTEST_TEST_CACHE_VARIABLE");
+        ASSERT_NE(withVariable.Key("Suite", "test"), withChangedVariable.Key("Suite", "test"));
+    }
+
+    TEST(ResultCache, StoredPassesAreFound) {
+        auto cache = EmptyCache();
+        ASSERT_FALSE(cache.Lookup("Suite", "test"));
+        cache.StorePass("Suite", "test");
+        // Never looked up so can't be stored
+        cache.StorePass("Suite", "unknown");
+
+        ResultCache nextRun(cacheDirectory, "binary", "", 100);
+        ASSERT_TRUE(nextRun.Lookup("Suite", "test"));
+        ASSERT_FALSE(nextRun.Lookup("Suite", "unknown"));
+    }
+
+    TEST(ResultCache, EvictionKeepsMaximumEntries) {
+        auto cache = EmptyCache("", 2);
+        for (const auto* test : {"a", "b", "c", "d"}) {
+            ASSERT_FALSE(cache.Lookup("Suite", test));
+            cache.StorePass("Suite", test);
+        }
+        cache.Evict();
+        ResultCache nextRun(cacheDirectory, "binary", "", 100);
+        int found = 0;
+        for (const auto* test : {"a", "b", "c", "d"}) {
+            found += nextRun.Lookup("Suite", test) ? 1 : 0;
+        }
+        ASSERT_EQ(found, 2);
+    }
+
+    TEST(ResultCache, CachedTestsOnlyConstructTheFixture) {
+        ::CppUnit::to::gtest::TestData<PartlyCachedSuite> data{[](PartlyCachedSuite& suite) { suite.test(); }, __LINE__, "test"};
+        PartlyCachedSuite::calls = 0;
+        ::CppUnit::to::gtest::CachedPassFixture<::CppUnit::to::gtest::DynamicTest<PartlyCachedSuite>> cached{data};
+        cached.SetUp();
+        cached.TestBody();
+        cached.TearDown();
+        ASSERT_EQ(PartlyCachedSuite::calls, 0);
+    }
+}
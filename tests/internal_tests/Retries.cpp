@@ -0,0 +1,206 @@
+/// Tests retrying failed tests in process when CppUnit2Gtest_EnableRetries is defined
+
+#define CppUnit2Gtest_EnableRetries
+#define CppUnit2Gtest_EnableTimeouts
+#define CppUnit2Gtest_EnableForkIsolation
+#include <cppunit/extensions/HelperMacros.h>
+#include <gtest/gtest-spi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+
+namespace {
+
+    using ::CppUnit::to::gtest::RetriedTests;
+
+    // Fails its first two attempts, each attempt gets a new fixture but SetUpTestSuite runs once
+    struct FlakySuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( FlakySuite );
+        CPPUNIT_TEST_SUITE_PROPERTY( "retries", "3" );
+        CPPUNIT_TEST( failsTwice );
+        CPPUNIT_TEST( passesFirstTime );
+        CPPUNIT_TEST( recordsTheAttempts );
+        CPPUNIT_TEST_SUITE_END();
+
+        static int suiteSetUps;
+        static int attempts;
+        static int tearDowns;
+        int member = 0;
+
+        static void SetUpTestSuite() { ++suiteSetUps; }
+        static void TearDownTestSuite() { ASSERT_EQ(suiteSetUps, 1); }
+        void setUp() override { ++member; }
+        void tearDown() override { ++tearDowns; }
+
+        void failsTwice() {
+            ++attempts;
+            CPPUNIT_ASSERT_EQUAL(1, member++);
+            CPPUNIT_ASSERT_MESSAGE("Fails its first two attempts", attempts > 2);
+        }
+        void passesFirstTime() { CPPUNIT_ASSERT_EQUAL(1, member); }
+        void recordsTheAttempts() {
+            CPPUNIT_ASSERT_EQUAL(3, attempts);
+            CPPUNIT_ASSERT_EQUAL(1, suiteSetUps);
+            // Three attempts of failsTwice then passesFirstTime
+            CPPUNIT_ASSERT_EQUAL(4, tearDowns);
+            const auto& retried = RetriedTests();
+            const auto found = std::find_if(retried.begin(), retried.end(), [](const ::CppUnit::to::gtest::RetriedTest& test) {
+                return test.name.rfind("FlakySuite.", 0) == 0;
+            });
+            CPPUNIT_ASSERT(found != retried.end());
+            CPPUNIT_ASSERT_EQUAL(std::string("FlakySuite.failsTwice"), found->name);
+            CPPUNIT_ASSERT_EQUAL(3, found->attempts);
+            CPPUNIT_ASSERT(found->passed);
+            // passesFirstTime didn't need a retry
+            CPPUNIT_ASSERT(std::count_if(found, retried.end(), [](const ::CppUnit::to::gtest::RetriedTest& test) {
+                return test.name.rfind("FlakySuite.", 0) == 0;
+            }) == 1);
+        }
+    };
+    int FlakySuite::suiteSetUps = 0;
+    int FlakySuite::attempts = 0;
+    int FlakySuite::tearDowns = 0;
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( FlakySuite );
+
+    // The retry's fixture is built from the test's data like the first one, so it has its timeout
+    struct TimedFlakySuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( TimedFlakySuite );
+        CPPUNIT_TEST_SUITE_PROPERTY( "retries", "1" );
+        CPPUNIT_TEST_SUITE_PROPERTY( "timeout_ms", "60000" );
+        CPPUNIT_TEST( failsOnce );
+        CPPUNIT_TEST_SUITE_END();
+
+        static int attempts;
+
+        void failsOnce() {
+            const auto* test = dynamic_cast<::CppUnit::to::gtest::DynamicTest<TimedFlakySuite>*>(this);
+            CPPUNIT_ASSERT(test != nullptr && test->testData != nullptr);
+            CPPUNIT_ASSERT_EQUAL(std::string("60000"), *::CppUnit::to::gtest::FindProperty(test->testData->properties, "timeout_ms"));
+            CPPUNIT_ASSERT_MESSAGE("Fails its first attempt", ++attempts > 1);
+        }
+    };
+    int TimedFlakySuite::attempts = 0;
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( TimedFlakySuite );
+
+    // Each attempt is forked again, the count is in memory shared with the children
+    struct ForkedFlakySuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( ForkedFlakySuite );
+        CPPUNIT_TEST_SUITE_PROPERTY( "isolation", "fork" );
+        CPPUNIT_TEST_SUITE_PROPERTY( "failsOnce.retries", "2" );
+        CPPUNIT_TEST( failsOnce );
+        CPPUNIT_TEST( ranTwiceInChildren );
+        CPPUNIT_TEST_SUITE_END();
+
+        static int* attempts;
+        int member = 0;
+
+        static void SetUpTestSuite() {
+            void* shared = mmap(nullptr, sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            ASSERT_NE(shared, MAP_FAILED);
+            attempts = static_cast<int*>(shared);
+            *attempts = 0;
+        }
+        static void TearDownTestSuite() {
+            munmap(attempts, sizeof(int));
+            attempts = nullptr;
+        }
+
+        void failsOnce() {
+            // Every child starts from the untouched fixture
+            CPPUNIT_ASSERT_EQUAL(0, member++);
+            CPPUNIT_ASSERT_MESSAGE("Fails its first attempt", ++*attempts > 1);
+        }
+        void ranTwiceInChildren() {
+            CPPUNIT_ASSERT_EQUAL(2, *attempts);
+            const auto& retried = RetriedTests();
+            CPPUNIT_ASSERT(std::any_of(retried.begin(), retried.end(), [](const ::CppUnit::to::gtest::RetriedTest& test) {
+                return test.name == "ForkedFlakySuite.failsOnce" && test.attempts == 2 && test.passed;
+            }));
+        }
+    };
+    int* ForkedFlakySuite::attempts = nullptr;
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( ForkedFlakySuite );
+
+    // Not registered, it never passes
+    struct BrokenSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( BrokenSuite );
+        CPPUNIT_TEST( fails );
+        CPPUNIT_TEST_SUITE_END();
+
+        static int attempts;
+
+        void fails() { CPPUNIT_FAIL("attempt " + std::to_string(++attempts)); }
+    };
+    int BrokenSuite::attempts = 0;
+
+    TEST(Retries, FromThePropertyOrTheEnvironment) {
+        using ::CppUnit::to::gtest::Retries_;
+        const ::CppUnit::to::gtest::Properties none;
+        unsetenv("CPPUNIT2GTEST_RETRIES");
+        EXPECT_EQ(Retries_(none), 0);
+        setenv("CPPUNIT2GTEST_RETRIES", "2", 1);
+        EXPECT_EQ(Retries_(none), 2);
+        EXPECT_EQ(Retries_({{"retries", "0"}}), 0);
+        unsetenv("CPPUNIT2GTEST_RETRIES");
+        EXPECT_EQ(Retries_({{"retries", "5"}}), 5);
+        EXPECT_EQ(Retries_({{"retries", "-1"}}), 0);
+    }
+
+    TEST(Retries, AttemptsDontReportToTheTest) {
+        using namespace ::CppUnit::to::gtest;
+        ::testing::TestPartResultArray results;
+        RunAttemptStage_(results, []() { throw std::runtime_error("boom"); }, "the test body");
+        EXPECT_FALSE(::testing::Test::HasFailure());
+        ASSERT_EQ(results.size(), 1);
+        EXPECT_TRUE(AttemptFailed_(results));
+        EXPECT_FALSE(AttemptStopped_(results));
+        EXPECT_NE(FirstFailure_(results).find("boom"), std::string::npos);
+        EXPECT_NONFATAL_FAILURE(ReportAttempt_(results), "boom");
+    }
+
+    TEST(Retries, TheTestKeepsItsDeadlineAfterARetry) {
+        ::CppUnit::to::gtest::TestData<TimedFlakySuite> data{[](TimedFlakySuite& suite) { suite.failsOnce(); }, __LINE__, "failsOnce"};
+        data.properties.emplace_back("retries", "1");
+        data.properties.emplace_back("timeout_ms", "60000");
+        TimedFlakySuite::attempts = 0;
+        {
+            ::CppUnit::to::gtest::DynamicTest<TimedFlakySuite> test{data};
+            test.TestBody();
+            EXPECT_EQ(TimedFlakySuite::attempts, 2);
+            EXPECT_TRUE(::CppUnit::to::gtest::Watchdog::Instance().Armed());
+        }
+        EXPECT_FALSE(::CppUnit::to::gtest::Watchdog::Instance().Armed());
+    }
+
+    TEST(Retries, ReportsOnlyTheLastAttempt) {
+        ::CppUnit::to::gtest::TestData<BrokenSuite> data{[](BrokenSuite& suite) { suite.fails(); }, __LINE__, "fails"};
+        data.properties.emplace_back("retries", "2");
+        ::CppUnit::to::gtest::DynamicTest<BrokenSuite> test{data};
+        ::testing::TestPartResultArray results;
+        {
+            ::testing::ScopedFakeTestPartResultReporter reporter(
+                ::testing::ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD, &results);
+            test.TestBody();
+        }
+        EXPECT_EQ(BrokenSuite::attempts, 3);
+        ASSERT_EQ(results.size(), 1);
+        EXPECT_TRUE(results.GetTestPartResult(0).fatally_failed());
+        EXPECT_NE(std::string(results.GetTestPartResult(0).message()).find("attempt 3"), std::string::npos);
+        ASSERT_FALSE(RetriedTests().empty());
+        EXPECT_EQ(RetriedTests().back().name, "Retries.ReportsOnlyTheLastAttempt");
+        EXPECT_EQ(RetriedTests().back().attempts, 3);
+        EXPECT_FALSE(RetriedTests().back().passed);
+
+        std::ostringstream report;
+        ::CppUnit::to::gtest::WriteRetriedTests(report);
+        EXPECT_NE(report.str().find("Retries.ReportsOnlyTheLastAttempt\t3\tfailed\n"), std::string::npos);
+    }
+
+} // namespace
@@ -0,0 +1,138 @@
+/// Tests sampling the stacks of a test when CppUnit2Gtest_EnableSamplingProfiler is defined
+
+#define CppUnit2Gtest_EnableSamplingProfiler
+#include <cppunit/extensions/HelperMacros.h>
+#include "TemporaryFiles.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+namespace {
+
+    using ::CppUnit::to::gtest::SamplingProfiler;
+    using ::CppUnit::to::gtest::StackSamples;
+    using ::CppUnit::to::gtest::StackSamples_;
+
+    volatile unsigned long long sink = 0;
+
+    void spin(const std::chrono::milliseconds duration) {
+        const auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end) { sink = sink + 1; }
+    }
+
+    // Sampling is off unless CPPUNIT2GTEST_SAMPLE_TESTS names the test
+    struct UnsampledSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( UnsampledSuite );
+        CPPUNIT_TEST( spins );
+        CPPUNIT_TEST_SUITE_END();
+
+        void spins() { spin(std::chrono::milliseconds(1)); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( UnsampledSuite );
+
+    TEST(SamplingProfiler, FileNames) {
+        EXPECT_EQ(SamplingProfiler::FileName("out", "Suite", "test"), "out/Suite.test.folded");
+        EXPECT_EQ(SamplingProfiler::FileName(".", "Typed/0", "test/1"), "./Typed_0.test_1.folded");
+    }
+
+    TEST(SamplingProfiler, FoldsIdenticalStacks) {
+        StackSamples samples;
+        samples.Reset(3);
+        int root = 0, leaf = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            void** frames = &samples.frames[i * StackSamples::maxDepth];
+            // leaf to root
+            frames[0] = &leaf;
+            frames[1] = &root;
+            samples.depths[i] = i == 2 ? 1 : 2;
+        }
+        samples.next = 3;
+        std::ostringstream folded;
+        ::CppUnit::to::gtest::WriteFoldedStacks(folded, samples);
+        std::istringstream lines(folded.str());
+        std::string first, second, extra;
+        ASSERT_TRUE(std::getline(lines, first));
+        ASSERT_TRUE(std::getline(lines, second));
+        EXPECT_FALSE(std::getline(lines, extra));
+        // The two line stacks are "root;leaf 2" and "leaf 1"
+        const std::string& twice = first.find(';') != std::string::npos ? first : second;
+        const std::string& once = first.find(';') != std::string::npos ? second : first;
+        EXPECT_EQ(twice.substr(twice.rfind(' ')), " 2");
+        EXPECT_EQ(once.substr(once.rfind(' ')), " 1");
+        EXPECT_EQ(twice.substr(twice.find(';') + 1, twice.rfind(' ') - twice.find(';') - 1), once.substr(0, once.rfind(' ')));
+    }
+
+    TEST(SamplingProfiler, WalksFramesWithinTheStack) {
+        // Three frames, each holding the caller's frame pointer and the return address, the last one points off the stack
+        std::uintptr_t stack[6] = {};
+        const auto at = [&stack](const int slot) { return reinterpret_cast<std::uintptr_t>(&stack[slot]); };
+        stack[0] = at(2); stack[1] = 0x1001;
+        stack[2] = at(4); stack[3] = 0x1002;
+        stack[4] = at(0) - 64; stack[5] = 0x1003;
+        ucontext_t context{};
+#   if defined(__x86_64__)
+        context.uc_mcontext.gregs[REG_RIP] = 0x1000;
+        context.uc_mcontext.gregs[REG_RBP] = static_cast<greg_t>(at(0));
+#   else
+        context.uc_mcontext.pc = 0x1000;
+        context.uc_mcontext.regs[29] = at(0);
+#   endif
+        void* frames[StackSamples::maxDepth];
+        const int depth = ::CppUnit::to::gtest::WalkFrames_(context, frames, StackSamples::maxDepth, at(0), at(6));
+        ASSERT_EQ(depth, 4);
+        for (int frame = 0; frame < depth; ++frame) {
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(frames[frame]), 0x1000u + static_cast<unsigned>(frame));
+        }
+        EXPECT_EQ(::CppUnit::to::gtest::WalkFrames_(context, frames, 2, at(0), at(6)), 2);
+        EXPECT_EQ(::CppUnit::to::gtest::WalkFrames_(context, frames, StackSamples::maxDepth, at(2), at(6)), 1);
+    }
+
+    TEST(SamplingProfiler, SamplesTheRunningTest) {
+        SamplingProfiler::InstallHandler();
+        SamplingProfiler profiler;
+        profiler.filter = "SamplingProfiler.Samples*";
+        profiler.directory = internal_tests::TemporaryPath("samples");
+        mkdir(profiler.directory.c_str(), 0755);
+        const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+        ASSERT_TRUE(profiler.Start(*testInfo));
+        spin(std::chrono::milliseconds(100));
+        profiler.Stop();
+        const std::string path = SamplingProfiler::FileName(profiler.directory, "SamplingProfiler", "SamplesTheRunningTest");
+        std::ifstream folded(path);
+        std::string line;
+        size_t lines = 0;
+        while (std::getline(folded, line)) {
+            EXPECT_NE(line.find(' '), std::string::npos);
+            ++lines;
+        }
+        EXPECT_GT(lines, 0u);
+        std::remove(path.c_str());
+        rmdir(profiler.directory.c_str());
+    }
+
+    TEST(SamplingProfiler, OnlySamplesTheTestsThread) {
+        SamplingProfiler::InstallHandler();
+        SamplingProfiler profiler;
+        profiler.filter = "SamplingProfiler.Only*";
+        profiler.directory = internal_tests::TemporaryPath("samples");
+        mkdir(profiler.directory.c_str(), 0755);
+        const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+        ASSERT_TRUE(profiler.Start(*testInfo));
+        // The test's thread waits on the busy one, which uses none of its cpu time
+        std::thread busy([]() { spin(std::chrono::milliseconds(100)); });
+        busy.join();
+        profiler.Stop();
+        EXPECT_EQ(StackSamples_().Taken(), 0u);
+        std::remove(SamplingProfiler::FileName(profiler.directory, "SamplingProfiler", "OnlySamplesTheTestsThread").c_str());
+        rmdir(profiler.directory.c_str());
+    }
+}
@@ -0,0 +1,130 @@
+/// Tests the resource aware scheduler used when CppUnit2Gtest_EnableScheduling is defined
+
+#define CppUnit2Gtest_EnableScheduling
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace {
+
+    using ::CppUnit::to::gtest::MatchesFilter_;
+    using ::CppUnit::to::gtest::PlanUnits_;
+    using ::CppUnit::to::gtest::ResourcePool;
+    using ::CppUnit::to::gtest::ScheduledUnit;
+
+    struct SchedSmall : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( SchedSmall );
+        CPPUNIT_TEST( a );
+        CPPUNIT_TEST( b );
+        CPPUNIT_TEST_SUITE_END();
+        void a() {}
+        void b() {}
+    };
+    CPPUNIT_TEST_SUITE_REGISTRATION( SchedSmall );
+
+    struct SchedHungry : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( SchedHungry );
+        CPPUNIT_TEST_SUITE_PROPERTY( "memory_mb", "4096" );
+        CPPUNIT_TEST_SUITE_PROPERTY( "cpus", "2" );
+        CPPUNIT_TEST( a );
+        CPPUNIT_TEST( b );
+        CPPUNIT_TEST_SUITE_PROPERTY( "b.cpus", "8" );
+        CPPUNIT_TEST_SUITE_END();
+        void a() {}
+        void b() {}
+    };
+    CPPUNIT_TEST_SUITE_REGISTRATION( SchedHungry );
+
+    struct SchedParallel : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( SchedParallel );
+        CPPUNIT_TEST_SUITE_PROPERTY( "parallel_safe", "true" );
+        CPPUNIT_TEST( a );
+        CPPUNIT_TEST( b );
+        CPPUNIT_TEST( slowOne );
+        CPPUNIT_TEST_SUITE_PROPERTY( "slowOne.slow", "true" );
+        CPPUNIT_TEST_SUITE_END();
+        void a() {}
+        void b() {}
+        void slowOne() {}
+    };
+    CPPUNIT_TEST_SUITE_REGISTRATION( SchedParallel );
+
+    struct SchedExclusive : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( SchedExclusive );
+        CPPUNIT_TEST_SUITE_PROPERTY( "exclusive", "true" );
+        CPPUNIT_TEST( a );
+        CPPUNIT_TEST_SUITE_END();
+        void a() {}
+    };
+    CPPUNIT_TEST_SUITE_REGISTRATION( SchedExclusive );
+
+    ScheduledUnit Unit(const unsigned cpus, const unsigned long long memoryMb, const bool exclusive = false) {
+        ScheduledUnit unit;
+        unit.cpus = cpus;
+        unit.memoryMb = memoryMb;
+        unit.exclusive = exclusive;
+        return unit;
+    }
+
+    TEST(Scheduling, MatchesGtestFilters) {
+        ASSERT_TRUE(MatchesFilter_("", "Suite.test"));
+        ASSERT_TRUE(MatchesFilter_("*", "Suite.test"));
+        ASSERT_TRUE(MatchesFilter_("Other.*:Suite.t?st", "Suite.test"));
+        ASSERT_FALSE(MatchesFilter_("Suite.t", "Suite.test"));
+        ASSERT_FALSE(MatchesFilter_("-Suite.*", "Suite.test"));
+        ASSERT_FALSE(MatchesFilter_("*-*.test:Other.*", "Suite.test"));
+        ASSERT_TRUE(MatchesFilter_("S*e.*-Other.*", "Suite.test"));
+    }
+
+    TEST(Scheduling, PlansUnitsFromProperties) {
+        const auto units = PlanUnits_("Sched*-Scheduling.*", false);
+        std::vector<std::string> filters;
+        for (const auto& unit : units) { filters.push_back(unit.filter); }
+        ASSERT_EQ(filters, (std::vector<std::string>{
+            "SchedExclusive.a",
+            "SchedParallel.slowOne",
+            "SchedHungry.a:SchedHungry.b",
+            "SchedSmall.a:SchedSmall.b",
+            "SchedParallel.a",
+            "SchedParallel.b",
+        }));
+        ASSERT_EQ(units[2].cpus, 8u);
+        ASSERT_EQ(units[2].memoryMb, 4096u);
+        ASSERT_TRUE(units[0].exclusive);
+        ASSERT_TRUE(units[1].slow);
+        ASSERT_EQ(units[4].name, "SchedParallel.a");
+        ASSERT_EQ(units[3].name, "SchedSmall");
+    }
+
+    TEST(Scheduling, NeverOversubscribes) {
+        ResourcePool pool({0, 1, 2, 3}, 8000);
+        const auto hungry = Unit(1, 5000);
+        const auto small = Unit(1, 100);
+        ASSERT_TRUE(pool.CanStart(hungry));
+        const auto first = pool.Start(hungry);
+        ASSERT_FALSE(pool.CanStart(hungry));
+        ASSERT_TRUE(pool.CanStart(small));
+        const auto second = pool.Start(Unit(3, 100));
+        ASSERT_EQ(second.cpuIds, (std::vector<int>{1, 2, 3}));
+        ASSERT_FALSE(pool.CanStart(small));
+        pool.Finish(first);
+        ASSERT_TRUE(pool.CanStart(hungry));
+        // Bigger than the machine runs on all of it
+        ASSERT_FALSE(pool.CanStart(Unit(64, 0)));
+        pool.Finish(second);
+        ASSERT_TRUE(pool.CanStart(Unit(64, 64000)));
+        ASSERT_EQ(pool.Start(Unit(64, 0)).cpuIds.size(), 4u);
+    }
+
+    TEST(Scheduling, ExclusiveUnitsRunAlone) {
+        ResourcePool pool({0, 1, 2, 3}, 0);
+        const auto exclusive = Unit(1, 0, true);
+        const auto small = pool.Start(Unit(1, 0));
+        ASSERT_FALSE(pool.CanStart(exclusive));
+        pool.Finish(small);
+        ASSERT_TRUE(pool.CanStart(exclusive));
+        const auto running = pool.Start(exclusive);
+        ASSERT_FALSE(pool.CanStart(Unit(1, 0)));
+        pool.Finish(running);
+        ASSERT_TRUE(pool.CanStart(Unit(1, 0)));
+    }
+
+} // namespace
@@ -0,0 +1,108 @@
+/// Tests the CppUnit style xml (and json lines) written as tests finish
+///  when CppUnit2Gtest_EnableStreamingOutput is defined
+
+#define CppUnit2Gtest_EnableStreamingOutput
+#include <cppunit/extensions/HelperMacros.h>
+#include "TemporaryFiles.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+    using ::CppUnit::to::gtest::CppUnitXmlStream;
+    using ::CppUnit::to::gtest::StreamedFailure;
+
+    std::string ReadFile(const std::string& path) {
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    size_t Count(const std::string& text, const std::string& what) {
+        size_t count = 0;
+        for (auto position = text.find(what); position != std::string::npos; position = text.find(what, position + 1)) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Registering a suite installs the listener when CPPUNIT2GTEST_XML_OUTPUT or CPPUNIT2GTEST_JSONL_OUTPUT is set
+    struct StreamedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( StreamedSuite );
+        CPPUNIT_TEST( streamed );
+        CPPUNIT_TEST_SUITE_END();
+        void streamed() { CPPUNIT_ASSERT( true ); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( StreamedSuite );
+
+    const std::string xmlPath = internal_tests::TemporaryFile("streamed.xml");
+    const std::string jsonPath = internal_tests::TemporaryFile("streamed.jsonl");
+
+    TEST(StreamingOutput, WellFormedAfterEveryTest) {
+        CppUnitXmlStream stream(xmlPath, jsonPath);
+        ASSERT_EQ(ReadFile(xmlPath).substr(ReadFile(xmlPath).size() - 11), "</TestRun>\n");
+
+        stream.AddTest("Suite", "passes", {});
+        stream.Flush();
+        auto xml = ReadFile(xmlPath);
+        ASSERT_EQ(Count(xml, "<SuccessfulTests>"), Count(xml, "</SuccessfulTests>"));
+        ASSERT_EQ(Count(xml, "<Name>Suite::passes</Name>"), 1);
+        ASSERT_EQ(xml.substr(xml.size() - 11), "</TestRun>\n");
+
+        // Failures are written without an explicit flush
+        stream.AddTest("Suite", "fails", {StreamedFailure{false, "file.cpp", 12, "1 == 2 & <more>"}});
+        xml = ReadFile(xmlPath);
+        ASSERT_EQ(Count(xml, "<FailedTests>"), 1);
+        ASSERT_EQ(Count(xml, "</FailedTests>"), 1);
+        ASSERT_EQ(Count(xml, "<Message>1 == 2 &amp; &lt;more&gt;"), 1);
+        ASSERT_EQ(Count(xml, "<Tests>2</Tests>"), 1);
+        ASSERT_EQ(xml.substr(xml.size() - 11), "</TestRun>\n");
+    }
+
+    TEST(StreamingOutput, OnlyThrowingTestsAreErrors) {
+        using ::CppUnit::to::gtest::IsExceptionFailure_;
+        EXPECT_TRUE(IsExceptionFailure_("C++ exception with description \"bad\" thrown in the test body."));
+        EXPECT_TRUE(IsExceptionFailure_("Unknown C++ exception thrown in SetUp()."));
+        // Assertions that talk about exceptions are still failures
+        EXPECT_FALSE(IsExceptionFailure_("Expected: f() throws an exception of type std::logic_error.\n  Actual: it throws nothing."));
+        EXPECT_FALSE(IsExceptionFailure_("the exception wasn't thrown"));
+    }
+
+    TEST(StreamingOutput, FinishHasOneSectionOfEach) {
+        {
+            CppUnitXmlStream stream(xmlPath, jsonPath);
+            stream.AddTest("Suite", "first", {});
+            stream.AddTest("Suite", "throws", {StreamedFailure{true, "", 0, "exception thrown"}});
+            stream.AddTest("Suite", "second", {}, true);
+            stream.AddTest("Suite", "fails", {StreamedFailure{false, "file.cpp", 3, "nope"}});
+            stream.Finish();
+            stream.AddTest("Suite", "ignored", {});
+        }
+        const auto xml = ReadFile(xmlPath);
+        ASSERT_EQ(Count(xml, "<FailedTests>"), 1);
+        ASSERT_EQ(Count(xml, "<SuccessfulTests>"), 1);
+        ASSERT_LT(xml.find("<FailedTests>"), xml.find("<SuccessfulTests>"));
+        ASSERT_EQ(Count(xml, "<FailedTest id="), 2);
+        ASSERT_EQ(Count(xml, "<Test id="), 2);
+        ASSERT_EQ(Count(xml, "<FailureType>Error</FailureType>"), 1);
+        ASSERT_EQ(Count(xml, "<Statistics><Tests>4</Tests><FailuresTotal>2</FailuresTotal><Errors>1</Errors><Failures>1</Failures>"), 1);
+        ASSERT_EQ(Count(xml, "ignored"), 0);
+
+        const auto json = ReadFile(jsonPath);
+        ASSERT_EQ(Count(json, "\n"), 4);
+        ASSERT_EQ(Count(json, "\"result\":\"skipped\""), 1);
+        ASSERT_EQ(Count(json, "\"result\":\"error\""), 1);
+        ASSERT_EQ(Count(json, "{\"file\":\"file.cpp\",\"line\":3,\"message\":\"nope\"}"), 1);
+    }
+
+    TEST(StreamingOutput, JsonOnly) {
+        CppUnitXmlStream stream("", jsonPath);
+        stream.AddTest("Suite", "quote\"d", {});
+        stream.Finish();
+        ASSERT_EQ(Count(ReadFile(jsonPath), "quote\\\"d"), 2);
+    }
+}
@@ -0,0 +1,46 @@
+/// Per process temporary files for the internal tests. Other runs of the test binary (i.e. under ctest -j)
+///  use their own paths, and what a process leaves behind is removed when it exits (not when a forked child does)
+
+#ifndef CPPUNIT2GTEST_INTERNAL_TESTS_TEMPORARY_FILES_H_
+#define CPPUNIT2GTEST_INTERNAL_TESTS_TEMPORARY_FILES_H_
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace internal_tests {
+
+    /// A path in gtest's temporary directory that only this process uses
+    inline std::string TemporaryPath(const std::string& name) {
+        return ::testing::TempDir() + "CppUnit2Gtest_" + std::to_string(getpid()) + "_" + name;
+    }
+
+    /// Runs the cleanup when the process exits, latest first. Forked children exiting don't run them
+    inline void CleanUpAtExit(std::function<void()> cleanup) {
+        struct Cleanups {
+            std::vector<std::function<void()>> cleanups;
+            pid_t owner = getpid();
+            ~Cleanups() {
+                if (getpid() != owner) { return; }
+                for (auto cleanup = cleanups.rbegin(); cleanup != cleanups.rend(); ++cleanup) { (*cleanup)(); }
+            }
+        };
+        static Cleanups atExit;
+        atExit.cleanups.push_back(std::move(cleanup));
+    }
+
+    /// TemporaryPath(name), the file is removed when the process exits
+    inline std::string TemporaryFile(const std::string& name) {
+        const std::string path = TemporaryPath(name);
+        CleanUpAtExit([path]() { std::remove(path.c_str()); });
+        return path;
+    }
+}
+
+#endif // CPPUNIT2GTEST_INTERNAL_TESTS_TEMPORARY_FILES_H_
@@ -0,0 +1,74 @@
+/// Tests that CPPUNIT_TEST_SUITE_PROPERTY gives properties to the tests in a suite
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct PropertySuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( PropertySuite );
+        CPPUNIT_TEST_SUITE_PROPERTY( "owner", "team_a" );
+        CPPUNIT_TEST( first );
+        CPPUNIT_TEST( second );
+        CPPUNIT_TEST_SUITE_PROPERTY( "second.owner", "team_b" );
+        CPPUNIT_TEST_SUITE_PROPERTY( "owner.email", "a@example.com" );
+        CPPUNIT_TEST_SUITE_END();
+        void first() {}
+        void second() {}
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( PropertySuite );
+
+    // Records what it was given, gtest fails tests recording its own attributes
+    struct RecordedPropertySuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( RecordedPropertySuite );
+        CPPUNIT_TEST_SUITE_PROPERTY( "name", "not the test name" );
+        CPPUNIT_TEST_SUITE_PROPERTY( "retries", "0" );
+        CPPUNIT_TEST_SUITE_PROPERTY( "owner", "team_a" );
+        CPPUNIT_TEST( recordsProperties );
+        CPPUNIT_TEST_SUITE_END();
+
+        void recordsProperties() {
+            const auto* result = ::testing::UnitTest::GetInstance()->current_test_info()->result();
+            std::vector<std::string> keys;
+            for (int i = 0; i < result->test_property_count(); ++i) {
+                keys.emplace_back(result->GetTestProperty(i).key());
+            }
+            CPPUNIT_ASSERT((keys == std::vector<std::string>{"property_name", "owner"}));
+        }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( RecordedPropertySuite );
+
+    TEST(TestProperties, SuiteWidePropertyAppliesToAllTests) {
+        const auto all = PropertySuite::GetAllTests_();
+        ASSERT_EQ(all.size(), 2);
+        for (const auto& test : all) {
+            const auto* email = ::CppUnit::to::gtest::FindProperty(test.properties, "owner.email");
+            ASSERT_NE(email, nullptr) << "Dotted key that isn't a test name is suite wide";
+            ASSERT_EQ(*email, "a@example.com");
+        }
+        ASSERT_EQ(*::CppUnit::to::gtest::FindProperty(all.at(0).properties, "owner"), "team_a");
+    }
+
+    TEST(TestProperties, PerTestPropertyOverridesSuite) {
+        const auto all = PropertySuite::GetAllTests_();
+        ASSERT_EQ(*::CppUnit::to::gtest::FindProperty(all.at(1).properties, "owner"), "team_b");
+        ASSERT_EQ(::CppUnit::to::gtest::FindProperty(all.at(1).properties, "second.owner"), nullptr);
+    }
+
+    TEST(TestProperties, RecordedNames) {
+        using namespace ::CppUnit::to::gtest;
+        EXPECT_TRUE(IsControlProperty_("timeout_ms"));
+        EXPECT_FALSE(IsControlProperty_("owner"));
+        EXPECT_EQ(RecordedPropertyName_("time"), "property_time");
+        EXPECT_EQ(RecordedPropertyName_("owner"), "owner");
+    }
+
+    TEST(TestProperties, MissingProperty) {
+        const ::CppUnit::to::gtest::Properties none{};
+        ASSERT_EQ(::CppUnit::to::gtest::FindProperty(none, "owner"), nullptr);
+    }
+}
@@ -0,0 +1,72 @@
+/// Tests the per test deadline that is enforced when CppUnit2Gtest_EnableTimeouts is defined
+
+#define CppUnit2Gtest_EnableTimeouts
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace {
+
+    using ::CppUnit::to::gtest::Watchdog;
+
+    struct QuickWithDeadline : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( QuickWithDeadline );
+        CPPUNIT_TEST_SUITE_PROPERTY( "timeout_ms", "5000" );
+        CPPUNIT_TEST( quick );
+        CPPUNIT_TEST( noDeadline );
+        CPPUNIT_TEST_SUITE_PROPERTY( "noDeadline.timeout_ms", "0" );
+        // Run by the TimeoutReport test, its timeout must still make it into gtest's xml report
+        CPPUNIT_TEST( DISABLED_overrunsItsDeadline );
+        CPPUNIT_TEST_SUITE_PROPERTY( "DISABLED_overrunsItsDeadline.timeout_ms", "50" );
+        CPPUNIT_TEST_SUITE_END();
+        void quick() { CPPUNIT_ASSERT( true ); }
+        void noDeadline() { CPPUNIT_ASSERT( true ); }
+        void DISABLED_overrunsItsDeadline() { std::this_thread::sleep_for(std::chrono::seconds(5)); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( QuickWithDeadline );
+
+    TEST(Timeouts, DisarmedWatchdogDoesNothing) {
+        // Would abort if it fired
+        Watchdog watchdog{};
+        watchdog.Arm("Timeouts.DisarmedWatchdogDoesNothing", std::chrono::milliseconds(50));
+        watchdog.Disarm();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // Zero never fires
+        watchdog.Arm("Timeouts.DisarmedWatchdogDoesNothing", std::chrono::milliseconds(0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+#if GTEST_HAS_DEATH_TEST
+    TEST(TimeoutsDeathTest, ExpiryAborts) {
+        ASSERT_DEATH({
+            Watchdog watchdog{};
+            watchdog.Arm("Timeouts.ExpiryAborts", std::chrono::milliseconds(10));
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+        }, "exceeded 10 ms");
+    }
+
+#   if defined(__linux__) && defined(__GLIBC__)
+    TEST(TimeoutsDeathTest, ExpiryPrintsTheTestsStack) {
+        ASSERT_DEATH({
+            Watchdog watchdog{};
+            watchdog.Arm("Timeouts.ExpiryPrintsTheTestsStack", std::chrono::milliseconds(10));
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+        }, "Stack of thread");
+    }
+
+    TEST(TimeoutsDeathTest, ThreadsBlockingTheSignalAreSkipped) {
+        ASSERT_DEATH({
+            std::thread blocking{[] {
+                sigset_t signals;
+                sigemptyset(&signals);
+                sigaddset(&signals, CppUnit2Gtest_StackDumpSignal);
+                pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+                std::this_thread::sleep_for(std::chrono::seconds(5));
+            }};
+            Watchdog watchdog{};
+            watchdog.Arm("Timeouts.ThreadsBlockingTheSignalAreSkipped", std::chrono::milliseconds(10));
+            blocking.join();
+        }, "did not respond");
+    }
+#   endif
+#endif
+}
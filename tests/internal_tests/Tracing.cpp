@@ -0,0 +1,80 @@
+/// Tests writing a trace of the run when CppUnit2Gtest_EnableTracing is defined
+
+#define CppUnit2Gtest_EnableTracing
+#include <cppunit/extensions/HelperMacros.h>
+#include "TemporaryFiles.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+    using ::CppUnit::to::gtest::TraceWriter;
+
+    // Traced only when CPPUNIT2GTEST_TRACE_FILE is set
+    struct TracedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( TracedSuite );
+        CPPUNIT_TEST( runs );
+        CPPUNIT_TEST_SUITE_END();
+
+        static int suiteSetUps;
+        static int suiteTearDowns;
+        static void SetUpTestSuite() { ++suiteSetUps; }
+        static void TearDownTestSuite() { ++suiteTearDowns; }
+
+        int value = 0;
+        void setUp() override { value = 1; }
+        void tearDown() override { CPPUNIT_ASSERT_EQUAL(2, value); }
+        void runs() { ++value; }
+    };
+    int TracedSuite::suiteSetUps = 0;
+    int TracedSuite::suiteTearDowns = 0;
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( TracedSuite );
+
+    TEST(Tracing, SuiteSetUpAndTearDownAreForwarded) {
+        const int setUps = TracedSuite::suiteSetUps;
+        const int tearDowns = TracedSuite::suiteTearDowns;
+        ::CppUnit::to::gtest::DynamicTest<TracedSuite>::SetUpTestSuite();
+        ::CppUnit::to::gtest::DynamicTest<TracedSuite>::TearDownTestSuite();
+        EXPECT_EQ(TracedSuite::suiteSetUps, setUps + 1);
+        EXPECT_EQ(TracedSuite::suiteTearDowns, tearDowns + 1);
+    }
+
+    TEST(Tracing, EscapesNames) {
+        EXPECT_EQ(::CppUnit::to::gtest::TraceEscape_("a\"b\\c\nd"), "a\\\"b\\\\c d");
+    }
+
+    TEST(Tracing, BuffersCompleteEvents) {
+        auto& buffer = ::CppUnit::to::gtest::TraceBuffer_();
+        (void)buffer.Take();
+        ::CppUnit::to::gtest::TraceComplete_("test", "Suite.\"test\"", 1.5, 4);
+        const std::string events = buffer.Take();
+        std::ostringstream expected;
+        expected << "{\"name\":\"Suite.\\\"test\\\"\",\"cat\":\"test\",\"ph\":\"X\",\"ts\":1.500,\"dur\":2.500,\"pid\":"
+                 << buffer.process << ",\"tid\":" << buffer.thread << "},\n";
+        EXPECT_EQ(events, expected.str());
+        EXPECT_EQ(buffer.count, 0u);
+    }
+
+    TEST(Tracing, WriterEndsTheArrayOnce) {
+        const std::string path = internal_tests::TemporaryPath("trace.json");
+        {
+            TraceWriter writer(path);
+            ASSERT_TRUE(writer.IsOpen());
+            EXPECT_GE(writer.Now(), 0);
+            writer.Write("{\"a\":1},\n");
+            writer.Close("{\"b\":2},\n");
+            writer.Write("{\"c\":3},\n");
+        }
+        std::ifstream file(path);
+        const std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        EXPECT_EQ(contents.substr(0, 20), "[\n{\"a\":1},\n{\"b\":2},\n");
+        EXPECT_NE(contents.find("\"process_name\""), std::string::npos);
+        EXPECT_EQ(contents.substr(contents.size() - 4), "}\n]\n");
+        EXPECT_EQ(contents.find("\"c\""), std::string::npos);
+        std::remove(path.c_str());
+    }
+}
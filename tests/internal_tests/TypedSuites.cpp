@@ -0,0 +1,67 @@
+/// Tests registering templated fixtures over lists of types
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+namespace typed_suites {
+
+    struct Square { static int sides() { return 4; } };
+    struct Triangle { static int sides() { return 3; } };
+    template<typename A, typename B>
+    struct Pair { static int sides() { return A::sides() + B::sides(); } };
+
+    template<typename Shape>
+    struct ShapeTest : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( ShapeTest );
+        CPPUNIT_TEST( hasSides );
+        CPPUNIT_TEST( isNotRound );
+        CPPUNIT_TEST_SUITE_END();
+
+        void hasSides() { CPPUNIT_ASSERT(Shape::sides() > 0); }
+        void isNotRound() { CPPUNIT_ASSERT(Shape::sides() != 0); }
+    };
+
+    // The instantiation can live in one file while others only declare it
+    extern template struct ShapeTest<Square>;
+    template struct ShapeTest<Square>;
+
+    CPPUNIT_TYPED_TEST_SUITE_REGISTRATION( ShapeTest, Square, Pair<Square, Triangle> );
+    // Types of the same fixture can be split over registrations without changing names
+    CPPUNIT_TYPED_TEST_SUITE_REGISTRATION( ShapeTest, Triangle );
+    CPPUNIT_TYPED_TEST_SUITE_NAMED_REGISTRATION( ShapeTest, "Shapes", Triangle );
+
+    std::vector<std::string> registered(const std::string& prefix) {
+        std::vector<std::string> names;
+        const auto* unitTest = ::testing::UnitTest::GetInstance();
+        for (int i = 0; i < unitTest->total_test_suite_count(); ++i) {
+            const auto* testSuite = unitTest->GetTestSuite(i);
+            const std::string name = testSuite->name();
+            if (name.rfind(prefix, 0) != 0) { continue; }
+            for (int j = 0; j < testSuite->total_test_count(); ++j) {
+                const auto* testInfo = testSuite->GetTestInfo(j);
+                names.push_back(name + "." + testInfo->name() + " " + testInfo->type_param());
+            }
+        }
+        return names;
+    }
+
+    TEST(TypedSuites, RegistersEveryType) {
+        EXPECT_EQ(registered("ShapeTest/"), (std::vector<std::string>{
+            "ShapeTest/typed_suites_Square.hasSides typed_suites::Square",
+            "ShapeTest/typed_suites_Square.isNotRound typed_suites::Square",
+            "ShapeTest/typed_suites_Pair_typed_suites_Square_typed_suites_Triangle.hasSides typed_suites::Pair<typed_suites::Square, typed_suites::Triangle>",
+            "ShapeTest/typed_suites_Pair_typed_suites_Square_typed_suites_Triangle.isNotRound typed_suites::Pair<typed_suites::Square, typed_suites::Triangle>",
+            "ShapeTest/typed_suites_Triangle.hasSides typed_suites::Triangle",
+            "ShapeTest/typed_suites_Triangle.isNotRound typed_suites::Triangle",
+        }));
+        EXPECT_EQ(registered("Shapes/").size(), 2u);
+    }
+
+    TEST(TypedSuites, FilterSafeNames) {
+        EXPECT_EQ(::CppUnit::to::gtest::FilterSafeName_("ns::Pair<int, char>"), "ns_Pair_int_char");
+        EXPECT_EQ(::CppUnit::to::gtest::FilterSafeName_("unsigned int"), "unsigned_int");
+        EXPECT_EQ(::CppUnit::to::gtest::FilterSafeName_("Plain"), "Plain");
+    }
+}
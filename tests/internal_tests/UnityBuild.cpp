@@ -0,0 +1,37 @@
+/// Tests that registrations don't collide when files are merged by a unity build
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+namespace unity_build {
+
+    struct FirstMergedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( FirstMergedSuite );
+        CPPUNIT_TEST( runs );
+        CPPUNIT_TEST_SUITE_END();
+
+        void runs() { CPPUNIT_ASSERT(true); }
+    };
+
+    struct SecondMergedSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( SecondMergedSuite );
+        CPPUNIT_TEST( runs );
+        CPPUNIT_TEST_SUITE_END();
+
+        void runs() { CPPUNIT_ASSERT(true); }
+    };
+
+    // Registrations from merged files can end up on the same line
+    CPPUNIT_TEST_SUITE_REGISTRATION( FirstMergedSuite ); CPPUNIT_TEST_SUITE_REGISTRATION( SecondMergedSuite );
+
+    TEST(UnityBuild, SameLineRegistrations) {
+        const auto* unitTest = ::testing::UnitTest::GetInstance();
+        int found = 0;
+        for (int i = 0; i < unitTest->total_test_suite_count(); ++i) {
+            const std::string name = unitTest->GetTestSuite(i)->name();
+            if (name == "FirstMergedSuite" || name == "SecondMergedSuite") { ++found; }
+        }
+        EXPECT_EQ(found, 2);
+    }
+}
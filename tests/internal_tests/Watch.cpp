@@ -0,0 +1,86 @@
+/// Tests rerunning changed test binaries when CppUnit2Gtest_EnableWatch is defined
+
+#if defined(__linux__)
+#define CppUnit2Gtest_EnableWatch
+#include <cppunit/extensions/HelperMacros.h>
+#include "TemporaryFiles.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    const std::string directory = internal_tests::TemporaryPath("watch");
+    const std::string binary = directory + "/fake_tests";
+    const std::string log = directory + "/runs.log";
+
+    /// Stands in for a test binary, it logs the filter it ran with. Replaced like a linker does,
+    ///  so a run that is still going keeps reading the old file
+    void writeBinary(const std::string& comment) {
+        const std::string written = binary + ".tmp";
+        {
+            std::ofstream out(written, std::ios::trunc);
+            out << "#!/bin/sh\n# " << comment << "\necho \"$1\" >> " << log << "\n";
+        }
+        chmod(written.c_str(), 0755);
+        std::rename(written.c_str(), binary.c_str());
+    }
+
+    std::string readLog() {
+        std::ifstream in(log);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    /// Waits (for at most 10s) until the binary has run count times
+    bool waitForRuns(const size_t count) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        for (std::string runs = readLog(); static_cast<size_t>(std::count(runs.begin(), runs.end(), '\n')) < count; runs = readLog()) {
+            if (std::chrono::steady_clock::now() > deadline) { return false; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+
+    TEST(Watch, RerunsChangedBinariesWithTheLastFilter) {
+        mkdir(directory.c_str(), 0755);
+        std::remove(log.c_str());
+        writeBinary("first build");
+        int commands[2];
+        ASSERT_EQ(pipe(commands), 0);
+        std::thread editor([&]() {
+            // Each step waits for the run the one before caused
+            const auto edit = [&]() {
+                if (!waitForRuns(1)) { return false; }
+                // Not watched, runs nothing
+                std::ofstream(directory + "/notes.txt") << "unrelated";
+                writeBinary("rebuilt");
+                if (!waitForRuns(2)) { return false; }
+                const std::string filter = "Watched.*\n";
+                if (write(commands[1], filter.data(), filter.size()) != static_cast<ssize_t>(filter.size())) { return false; }
+                if (!waitForRuns(3)) { return false; }
+                writeBinary("rebuilt again");
+                return waitForRuns(4);
+            };
+            EXPECT_TRUE(edit()) << readLog();
+            // The watcher stops at the end of its commands
+            close(commands[1]);
+        });
+        EXPECT_EQ(::CppUnit::to::gtest::WatchTests({binary}, "", commands[0]), 0);
+        editor.join();
+        close(commands[0]);
+        EXPECT_EQ(readLog(), "--gtest_filter=*\n--gtest_filter=*\n--gtest_filter=Watched.*\n--gtest_filter=Watched.*\n");
+        std::remove(log.c_str());
+        std::remove(binary.c_str());
+        std::remove((directory + "/notes.txt").c_str());
+        rmdir(directory.c_str());
+    }
+}
+#endif
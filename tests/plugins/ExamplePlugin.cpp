@@ -0,0 +1,20 @@
+// A test plugin, loaded and run by CppUnit2Gtest_PluginRunner
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace {
+
+    struct PluginSuite : CPPUNIT_NS::TestFixture {
+        CPPUNIT_TEST_SUITE( PluginSuite );
+        CPPUNIT_TEST( runsInTheHost );
+        CPPUNIT_TEST( failsLikeAnyTest );
+        CPPUNIT_TEST_SUITE_END();
+
+        void runsInTheHost() { CPPUNIT_ASSERT_EQUAL(2, 1 + 1); }
+        void failsLikeAnyTest() { CPPUNIT_ASSERT_MESSAGE("only runs when asked", false); }
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( PluginSuite );
+}
+
+CPPUNIT_PLUGIN_IMPLEMENT();